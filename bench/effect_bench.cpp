@@ -0,0 +1,755 @@
+// Host benchmark for the effect render loops.
+//
+// Runs every effect for N frames over two folded 200-LED strips and reports
+// the wall-clock cost per frame and per pixel. Each effect is measured
+// rendering both full strips, and symmetric effects again on the
+// render-once "/line" path the firmware uses for them. Build and run with:
+//
+//   pio run -e native && .pio/build/native/program [frames]
+//
+// The checksum column is a hash of the final frame; it only changes when an
+// effect's output changes, so it doubles as a quick regression check. The
+// sent column is the share of frames that changed and would go to the strips.
+//
+// It also round-trips random frames through the UART WS2812 encoder used by
+// the async output, checks the word-wise crossfade against the per-byte
+// blend, checks the power estimate summed while composing against a plain
+// sum and the brightness limit against the budget, checks the fire heat
+// kernels, the flash palettes, the rainbow hues and the POV columns against
+// the plain code they replace, and checks that each effect ends on the same frame when
+// rendered at different frame intervals. Any of them failing exits non-zero.
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <chrono>
+#include "effects.h"
+#include "../src/version.h"
+#include "../src/Ws2812Encoder.h"
+#include "../src/Crossfade.h"
+#include "../src/Compositor.h"
+#include "../src/PowerLimiter.h"
+#include "../src/RamBudget.h"
+#include "../src/Effects/HeatKernel.h"
+
+static const int STRIP_LEDS = STAFF_STRIP_LEDS;
+static const int BENCH_STRIPS = 2;
+static const unsigned long BENCH_FRAME_MS = 50;  // FrameClock's slowest interval, FRAME_MAX_INTERVAL_US
+static const unsigned long DEFAULT_FRAMES = 2000;
+static const unsigned long WARMUP_FRAMES = 50;
+
+alignas(4) static CRGB strip1[STRIP_LEDS];
+alignas(4) static CRGB strip2[STRIP_LEDS];
+
+static uint32_t frameChecksum() {
+  // FNV-1a over both strips
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < STRIP_LEDS; i++) {
+    for (int c = 0; c < 3; c++) {
+      hash = (hash ^ strip1[i].raw[c]) * 16777619u;
+      hash = (hash ^ strip2[i].raw[c]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+static void resetState() {
+  fill_solid(strip1, STRIP_LEDS, CRGB::Black);
+  fill_solid(strip2, STRIP_LEDS, CRGB::Black);
+  hostClockReset();
+  random16_set_seed(1337);
+}
+
+static FrameTime nextFrame(unsigned long frameMs) {
+  hostClockAdvance(frameMs);
+  FrameTime time = { millis(), frameMs };
+  return time;
+}
+
+template <typename RenderFn>
+static void runBench(const char* name, RenderFn render, unsigned long frames) {
+  for (unsigned long f = 0; f < WARMUP_FRAMES; f++) {
+    render(nextFrame(BENCH_FRAME_MS));
+  }
+
+  double totalNs = 0;
+  unsigned long sent = 0;
+  for (unsigned long f = 0; f < frames; f++) {
+    FrameTime time = nextFrame(BENCH_FRAME_MS);
+    auto start = std::chrono::steady_clock::now();
+    bool changed = render(time);
+    auto end = std::chrono::steady_clock::now();
+    totalNs += std::chrono::duration<double, std::nano>(end - start).count();
+    if (changed) sent++;
+  }
+
+  double nsPerFrame = totalNs / frames;
+  double nsPerPixel = nsPerFrame / (STRIP_LEDS * BENCH_STRIPS);
+  printf("%-20s %12.1f %10.2f %6.1f%%   %08x\n", name, nsPerFrame, nsPerPixel,
+         100.0 * sent / frames, frameChecksum());
+}
+
+// Runs an effect the way the firmware draws symmetric effects: one instance
+// on the hilt-to-tip line, fanned out to both folded strips when it changed
+template <typename EffectT>
+static void runLineBench(const char* name, unsigned long frames) {
+  static CRGB line[STAFF_LINE_LEDS];
+  fill_solid(line, STAFF_LINE_LEDS, CRGB::Black);
+  EffectT effect(line, staffGeometry<LAYOUT_LINE>());
+  runBench(name, [&](const FrameTime& time) {
+    if (!effect.update(time)) {
+      return false;
+    }
+    fanOutLine(line, strip1, staffGeometry<LAYOUT_FOLDED>());
+    memcpy(strip2, strip1, sizeof(strip1));
+    return true;
+  }, frames);
+}
+
+// Checksum of the frame shown after durationMs of a symmetric effect
+// rendered at the given frame interval
+template <typename EffectT>
+static uint32_t lineFrameAt(unsigned long frameMs, unsigned long durationMs) {
+  static CRGB line[STAFF_LINE_LEDS];
+  resetState();
+  fill_solid(line, STAFF_LINE_LEDS, CRGB::Black);
+  EffectT effect(line, staffGeometry<LAYOUT_LINE>());
+  for (unsigned long t = 0; t < durationMs; t += frameMs) {
+    effect.update(nextFrame(frameMs));
+  }
+  fanOutLine(line, strip1, staffGeometry<LAYOUT_FOLDED>());
+  memcpy(strip2, strip1, sizeof(strip1));
+  return frameChecksum();
+}
+
+static uint32_t fireFrameAt(unsigned long frameMs, unsigned long durationMs) {
+  resetState();
+  FireEffect fire1(strip1, staffGeometry<LAYOUT_FOLDED>(), false);
+  FireEffect fire2(strip2, staffGeometry<LAYOUT_FOLDED>(), true);
+  for (unsigned long t = 0; t < durationMs; t += frameMs) {
+    FrameTime time = nextFrame(frameMs);
+    fire1.update(time);
+    fire2.update(time);
+  }
+  return frameChecksum();
+}
+
+// Animation speed must not depend on the frame rate: after the same time,
+// every frame interval has to end on the same frame
+static const unsigned long RATE_CHECK_MS = 3000;
+static const unsigned long RATE_CHECK_INTERVALS[] = { 50, 25, 20, 10 };
+
+template <typename FrameAtFn>
+static bool checkFrameRate(const char* name, FrameAtFn frameAt) {
+  uint32_t reference = frameAt(RATE_CHECK_INTERVALS[0], RATE_CHECK_MS);
+  for (unsigned long frameMs : RATE_CHECK_INTERVALS) {
+    if (frameAt(frameMs, RATE_CHECK_MS) != reference) {
+      printf("%s: frame after %lu ms differs at %lu ms frames\n", name, RATE_CHECK_MS, frameMs);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Decode UART bytes back to WS2812 bytes by replaying the line the LEDs see:
+// inverted 6N1 frames are a high start bit, the inverted data bits LSB first
+// and a low stop bit. Each WS2812 bit is 4 bit times, 1 of them high for a 0
+// and 3 for a 1. Returns false on any malformed bit.
+static bool decodeUart(const uint8_t* uart, size_t len, uint8_t* out) {
+  uint8_t value = 0;
+  int bits = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t line[8];
+    line[0] = 1;
+    for (int b = 0; b < 6; b++) {
+      line[1 + b] = ((uart[i] >> b) & 1) ^ 1;
+    }
+    line[7] = 0;
+
+    for (int half = 0; half < 2; half++) {
+      const uint8_t* w = line + half * 4;
+      if (w[0] != 1 || w[3] != 0 || (w[1] == 0 && w[2] == 1)) {
+        return false;
+      }
+      value = (value << 1) | w[2];
+      if (++bits == 8) {
+        *out++ = value;
+        bits = 0;
+      }
+    }
+  }
+  return bits == 0;
+}
+
+static bool verifyWs2812Encoder() {
+  static uint8_t uart[STRIP_LEDS * WS2812_UART_BYTES_PER_PIXEL];
+  static uint8_t decoded[STRIP_LEDS * 3];
+  const CRGB scales[] = { CRGB(255, 255, 255), ws2812Adjustment(96, CRGB(TypicalLEDStrip)) };
+
+  random16_set_seed(4242);
+  for (int frame = 0; frame < 64; frame++) {
+    for (int i = 0; i < STRIP_LEDS; i++) {
+      strip1[i] = CRGB(random8(), random8(), random8());
+    }
+    const CRGB& scale = scales[frame & 1];
+    size_t len = ws2812EncodeUart(strip1, STRIP_LEDS, scale, uart);
+    if (len != sizeof(uart) || !decodeUart(uart, len, decoded)) {
+      printf("WS2812 encoder: malformed output in frame %d\n", frame);
+      return false;
+    }
+    for (int i = 0; i < STRIP_LEDS; i++) {
+      const uint8_t* grb = decoded + i * 3;
+      if (grb[0] != scale8(strip1[i].g, scale.g) ||
+          grb[1] != scale8(strip1[i].r, scale.r) ||
+          grb[2] != scale8(strip1[i].b, scale.b)) {
+        printf("WS2812 encoder: pixel %d of frame %d decodes wrong\n", i, frame);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The word-wise kernel has to match the per-byte blend exactly, at every
+// weight, and on unaligned buffers (bytewise path)
+static bool verifyCrossfade() {
+  alignas(4) static CRGB from[STRIP_LEDS + 1];
+  alignas(4) static CRGB to[STRIP_LEDS + 1];
+  alignas(4) static CRGB out[STRIP_LEDS + 1];
+
+  random16_set_seed(777);
+  for (int i = 0; i <= STRIP_LEDS; i++) {
+    from[i] = CRGB(random8(), random8(), random8());
+    to[i] = CRGB(random8(), random8(), random8());
+  }
+  from[0] = CRGB(255, 255, 255);
+  to[1] = CRGB(255, 255, 255);
+
+  for (int offset = 0; offset < 2; offset++) {
+    for (uint16_t amount = 0; amount <= CROSSFADE_FULL; amount++) {
+      PowerEstimate power;
+      crossfadePixels(from + offset, to, out + offset, STRIP_LEDS, amount, power);
+      PowerEstimate reference;
+      for (int i = 0; i < STRIP_LEDS; i++) {
+        for (int c = 0; c < 3; c++) {
+          if (out[i + offset].raw[c] != crossfadeByte(from[i + offset].raw[c], to[i].raw[c], amount)) {
+            printf("Crossfade: pixel %d differs at weight %u (offset %d)\n", i, amount, offset);
+            return false;
+          }
+        }
+        reference.add(out[i + offset]);
+      }
+      for (int c = 0; c < 3; c++) {
+        if (power.channel[c] != reference.channel[c]) {
+          printf("Crossfade: channel %d power sum differs at weight %u (offset %d)\n", c, amount, offset);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// The fixed palettes in flash have to hold what HeatColor() and CHSV give
+static bool verifyPaletteTables() {
+  FlashPalette heat(HEAT_PALETTE_TABLE);
+  FlashPalette hue(HUE_PALETTE_TABLE);
+  for (uint16_t i = 0; i < 256; i++) {
+    if (heat[i] != HeatColor(i)) {
+      printf("Palette: heat entry %u differs from HeatColor()\n", i);
+      return false;
+    }
+    if (hue[i] != CRGB(CHSV(i, 255, 255))) {
+      printf("Palette: hue entry %u differs from CHSV\n", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// The heat kernels have to leave the same cells and the same random seed
+// as the fire's per-cell loops, at every cooling, on odd lengths and on
+// unaligned buffers (bytewise path)
+// Energy Pulse sums its waves over one period of distances; check it
+// against the original per-pixel loop for every wave count and layout
+static bool verifyPulseWaves() {
+  static const StaffGeometry* GEOMETRIES[] = {
+    &staffGeometry<LAYOUT_FOLDED>(), &staffGeometry<LAYOUT_LINEAR>(), &staffGeometry<LAYOUT_LINE>()
+  };
+  static CRGB leds[STRIP_LEDS];
+  static CRGB reference[STRIP_LEDS];
+  const unsigned long frameMs = 7;  // Not a multiple of PULSE_HUE_MS, so some frames don't move
+
+  for (const StaffGeometry* geometry : GEOMETRIES) {
+    int count = geometry->numLeds;
+
+    for (uint8_t waves = 1; waves <= PULSE_MAX_WAVES; waves++) {
+      resetState();
+      fill_solid(leds, count, CRGB::Black);
+      PulseEffect effect(leds, *geometry);
+      effect.setWaveCount(waves);
+
+      for (int frame = 0; frame < 400; frame++) {
+        FrameTime time = nextFrame(frameMs);
+        effect.update(time);
+        uint8_t baseHue = (uint8_t)(time.now / PULSE_HUE_MS);
+
+        for (int i = 0; i < count; i++) {
+          uint8_t d = geometry->distance[i];
+          uint16_t brightness = 0;
+          for (uint8_t w = 1; w <= waves; w++) {
+            brightness += scale8(sin8(beat8At(time.now, 10 * w) + d * 8), 255 / w);
+          }
+          reference[i] = CHSV(baseHue + d, 255, brightness > 255 ? 255 : brightness);
+        }
+
+        if (memcmp(leds, reference, count * sizeof(CRGB)) != 0) {
+          printf("Pulse: %u waves differ in frame %d (%d LEDs)\n", waves, frame, count);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// An effect rebuilt from its saved state (deep sleep resume) has to draw
+// the same next frame as the one that kept running
+template <typename EffectT, typename... Args>
+static bool checkResume(const char* name, const StaffGeometry& geometry, Args... args) {
+  static CRGB running[STRIP_LEDS];
+  static CRGB resumed[STRIP_LEDS];
+  static uint8_t state[STRIP_LEDS];
+  int count = geometry.numLeds;
+
+  resetState();
+  EffectT before(running, geometry, args...);
+  for (int frame = 0; frame < 60; frame++) {
+    before.update(nextFrame(BENCH_FRAME_MS));
+  }
+  uint16_t length = before.saveState(state, sizeof(state));
+  if (length == 0) {
+    printf("Resume: %s saved no state\n", name);
+    return false;
+  }
+  EffectT after(resumed, geometry, args...);
+  after.restoreState(state, length);
+
+  FrameTime time = nextFrame(BENCH_FRAME_MS);
+  uint16_t seed = random16_get_seed();
+  before.update(time);
+  random16_set_seed(seed);
+  after.update(time);
+  if (memcmp(running, resumed, count * sizeof(CRGB)) != 0) {
+    printf("Resume: %s draws a different frame after restoring %u bytes\n", name, length);
+    return false;
+  }
+  return true;
+}
+
+static bool verifyEffectResume() {
+  return checkResume<FireEffect>("Fire", staffGeometry<LAYOUT_FOLDED>(), false) &&
+         checkResume<PulseEffect>("Energy Pulse", staffGeometry<LAYOUT_LINE>()) &&
+         checkResume<RainbowEffect>("Rainbow", staffGeometry<LAYOUT_LINE>()) &&
+         checkResume<SolidEffect>("Solid Color", staffGeometry<LAYOUT_LINE>());
+}
+
+static bool verifyHeatKernel() {
+  for (uint16_t n = 0; n <= 765; n++) {
+    if (divide3(n) != n / 3) {
+      printf("Heat kernel: divide3(%u) is %u\n", n, divide3(n));
+      return false;
+    }
+  }
+
+  static const int LENGTHS[] = { STRIP_LEDS, STRIP_LEDS / 2, 37, 5, 3 };
+  alignas(4) static uint8_t heat[STRIP_LEDS + 1];
+  alignas(4) static uint8_t reference[STRIP_LEDS + 1];
+
+  for (int count : LENGTHS) {
+    for (int offset = 0; offset < 2; offset++) {
+      for (int cooling = 0; cooling < 256; cooling++) {
+        random16_set_seed(cooling * 31 + count);
+        for (int i = 0; i < count; i++) {
+          reference[i + offset] = heat[i + offset] = random8();
+        }
+        uint8_t limit = (uint8_t)((cooling * 10) / count + 2);
+        uint16_t seed = random16_get_seed();
+
+        uint8_t* ref = reference + offset;
+        for (int i = 0; i < count; i++) {
+          ref[i] = qsub8(ref[i], random8(0, limit));
+        }
+        uint16_t refSeed = random16_get_seed();
+        int mid = count / 2;
+        for (int k = mid - 1; k >= 2; k--) {
+          ref[k] = (ref[k - 1] + ref[k - 2] + ref[k - 2]) / 3;
+        }
+        for (int k = mid; k < count - 2; k++) {
+          ref[k] = (ref[k + 1] + ref[k + 2] + ref[k + 2]) / 3;
+        }
+
+        random16_set_seed(seed);
+        uint8_t* out = heat + offset;
+        coolHeat(out, count, limit);
+        riseHeat(out, 2, mid - 1);
+        fallHeat(out, mid, count - 3);
+
+        if (random16_get_seed() != refSeed || memcmp(ref, out, count) != 0) {
+          printf("Heat kernel: %d cells differ at cooling %d (offset %d)\n", count, cooling, offset);
+          return false;
+        }
+
+        // The straight (non-folded) drift over the whole length
+        for (int k = count - 1; k >= 2; k--) {
+          ref[k] = (ref[k - 1] + ref[k - 2] + ref[k - 2]) / 3;
+        }
+        riseHeat(out, 2, count - 1);
+        if (memcmp(ref, out, count) != 0) {
+          printf("Heat kernel: %d cells drift differently (offset %d)\n", count, offset);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// The moving rainbow and the twinkles have to keep the hues the original
+// map() calls gave them, on the folded strip and on the hilt-to-tip line
+static bool verifyRainbowHues() {
+  static const StaffGeometry* GEOMETRIES[] = { &staffGeometry<LAYOUT_FOLDED>(), &staffGeometry<LAYOUT_LINE>() };
+  static CRGB leds[STRIP_LEDS];
+  static CRGB reference[STRIP_LEDS];
+
+  for (const StaffGeometry* geometry : GEOMETRIES) {
+    int count = geometry->numLeds;
+    int midPoint = geometry->halfLength;
+
+    for (uint8_t mode = 1; mode <= 2; mode++) {
+      resetState();
+      fill_solid(leds, count, CRGB::Black);
+      fill_solid(reference, count, CRGB::Black);
+      RainbowEffect effect(leds, *geometry);
+      effect.setMode(mode);
+      uint8_t hue = 0;
+
+      for (int frame = 0; frame < 100; frame++) {
+        hue += 30 / 4;  // Default speed, one RAINBOW_STEP_MS step per frame
+        uint16_t seed = random16_get_seed();
+        effect.update(nextFrame(RAINBOW_STEP_MS));
+
+        if (mode == 1) {
+          for (int i = 0; i < count; i++) {
+            long offset = (i < midPoint) ? map(i, 0, midPoint - 1, 0, 128)
+                                         : map(i - midPoint, 0, midPoint - 1, 128, 255);
+            reference[i] = CHSV(hue + offset, 240, 255);
+          }
+        } else {
+          random16_set_seed(seed);
+          for (int i = 0; i < count; i++) {
+            reference[i].fadeToBlackBy(10);
+          }
+          for (int i = 0; i < count; i++) {
+            if (random8() < 50 / 10) {
+              long offset = map(geometry->distance[i], 0, midPoint, 0, 128);
+              reference[i] = CHSV(hue + offset + random8(64), 240, 255);
+            }
+          }
+        }
+
+        if (memcmp(leds, reference, count * sizeof(CRGB)) != 0) {
+          printf("Rainbow: mode %u hues differ in frame %d (%d LEDs)\n", mode, frame, count);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// The stepped POV column has to pick the same image pixel i * radius /
+// count as the per-pixel divide, for every column and column length
+static bool verifyPovColumns() {
+  static CRGB column[STRIP_LEDS];
+  PovEffect pov(column, staffGeometry<LAYOUT_LINE>(), POV_IMAGE, 0);
+  uint8_t radius = POV_IMAGE.radius;
+
+  for (uint8_t c = 0; c < POV_IMAGE.columns; c++) {
+    const uint8_t* pixels = POV_IMAGE.pixels + c * (radius / 2);
+    for (int count = 1; count <= 255 && count <= STRIP_LEDS; count++) {
+      pov.renderColumn(c, column, count);
+      for (int i = 0; i < count; i++) {
+        uint8_t r = (uint16_t)i * radius / count;
+        uint8_t packed = pgm_read_byte(pixels + r / 2);
+        uint8_t index = (r & 1) ? (packed >> 4) : (packed & 0x0F);
+        CRGB expected(pgm_read_byte(POV_IMAGE.palette + index * 3),
+                      pgm_read_byte(POV_IMAGE.palette + index * 3 + 1),
+                      pgm_read_byte(POV_IMAGE.palette + index * 3 + 2));
+        if (column[i] != expected) {
+          printf("POV: column %u pixel %d of %d differs\n", c, i, count);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// The word-wise copy has to sum every channel exactly, over more words
+// than the lanes can hold between flushes, and the limited brightness has
+// to keep the estimate within the budget
+static bool verifyPowerEstimate() {
+  alignas(4) static CRGB src[4 * STRIP_LEDS + 1];
+  alignas(4) static CRGB dst[4 * STRIP_LEDS + 1];
+  const int count = 4 * STRIP_LEDS;
+
+  random16_set_seed(99);
+  for (int i = 0; i <= count; i++) {
+    src[i] = CRGB(random8(), random8(), random8());
+  }
+  for (int i = 0; i < 8; i++) {
+    src[i] = CRGB(255, 255, 255);
+  }
+
+  for (int offset = 0; offset < 2; offset++) {
+    PowerEstimate power;
+    copyPixels(src + offset, dst + offset, count, power);
+    PowerEstimate reference;
+    for (int i = 0; i < count; i++) {
+      reference.add(src[i + offset]);
+    }
+    if (memcmp(src + offset, dst + offset, count * sizeof(CRGB)) != 0) {
+      printf("Power estimate: copy differs (offset %d)\n", offset);
+      return false;
+    }
+    for (int c = 0; c < 3; c++) {
+      if (power.channel[c] != reference.channel[c]) {
+        printf("Power estimate: channel %d sum differs (offset %d)\n", c, offset);
+        return false;
+      }
+    }
+  }
+
+  static const uint32_t BUDGETS[] = { 500, LED_POWER_BUDGET_MA, LED_POWER_BUDGET_LOW_MA, 100000 };
+  PowerEstimate white;
+  white.add(CRGB(255, 255, 255), 2 * STRIP_LEDS);
+  for (uint32_t budget : BUDGETS) {
+    for (int requested = 0; requested < 256; requested += 5) {
+      uint8_t limited = limitBrightness(white, requested, 2 * STRIP_LEDS, budget);
+      if (limited > requested || (white.milliamps(limited, 2 * STRIP_LEDS) > budget && limited > 0)) {
+        printf("Power limit: brightness %d limited to %u over a %lu mA budget\n", requested, limited,
+               (unsigned long)budget);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  unsigned long frames = DEFAULT_FRAMES;
+  if (argc > 1) {
+    frames = strtoul(argv[1], nullptr, 10);
+    if (frames == 0) frames = DEFAULT_FRAMES;
+  }
+
+  printf("BoStaff effect benchmark (version %s)\n", VERSION);
+  printf("%d strips x %d LEDs, folded, %lu frames at %lu ms\n\n",
+         BENCH_STRIPS, STRIP_LEDS, frames, BENCH_FRAME_MS);
+  printf("%-20s %12s %10s %7s   %8s\n", "effect", "ns/frame", "ns/pixel", "sent", "checksum");
+
+  const StaffGeometry& folded = staffGeometry<LAYOUT_FOLDED>();
+
+  // Per-strip rendering over the full folded layout
+  {
+    resetState();
+    FireEffect fire1(strip1, folded, false);
+    FireEffect fire2(strip2, folded, true);
+    runBench("Fire", [&](const FrameTime& t) { return fire1.update(t) | fire2.update(t); }, frames);
+  }
+
+  {
+    resetState();
+    PulseEffect pulse1(strip1, folded);
+    PulseEffect pulse2(strip2, folded);
+    runBench("Energy Pulse", [&](const FrameTime& t) { return pulse1.update(t) | pulse2.update(t); }, frames);
+  }
+
+  {
+    resetState();
+    RainbowEffect rainbow1(strip1, folded);
+    RainbowEffect rainbow2(strip2, folded);
+    runBench("Rainbow", [&](const FrameTime& t) { return rainbow1.update(t) | rainbow2.update(t); }, frames);
+  }
+
+  {
+    resetState();
+    StrobeEffect strobe1(strip1, folded);
+    StrobeEffect strobe2(strip2, folded);
+    runBench("Strobe", [&](const FrameTime& t) { return strobe1.update(t) | strobe2.update(t); }, frames);
+  }
+
+  {
+    resetState();
+    PovEffect pov1(strip1, folded, POV_IMAGE, 0);
+    PovEffect pov2(strip2, folded, POV_IMAGE, 0x80000000UL);
+    runBench("POV preview", [&](const FrameTime& t) { return pov1.update(t) | pov2.update(t); }, frames);
+  }
+
+  // What servicePov() draws per column while spinning: the outgoing row
+  // of each strip, one image column further on every call
+  {
+    resetState();
+    PovEffect pov1(strip1, folded, POV_IMAGE, 0);
+    PovEffect pov2(strip2, folded, POV_IMAGE, 0x80000000UL);
+    uint32_t phase = 0;
+    runBench("POV column", [&](const FrameTime&) {
+      phase += 0x100000000ULL / POV_IMAGE.columns;
+      pov1.renderColumn(pov1.columnAt(phase), strip1, STAFF_LINE_LEDS);
+      pov2.renderColumn(pov2.columnAt(phase), strip2, STAFF_LINE_LEDS);
+      return true;
+    }, frames);
+  }
+
+  // Render-once, fan-out path used for symmetric effects
+  resetState();
+  runLineBench<SolidEffect>("Solid Color/line", frames);
+  resetState();
+  runLineBench<PulseEffect>("Energy Pulse/line", frames);
+  resetState();
+  runLineBench<RainbowEffect>("Rainbow/line", frames);
+  resetState();
+  runLineBench<StrobeEffect>("Strobe/line", frames);
+
+  // Encoding both strips for the async UART output
+  {
+    static uint8_t uart[2][STRIP_LEDS * WS2812_UART_BYTES_PER_PIXEL];
+    resetState();
+    RainbowEffect rainbow1(strip1, folded);
+    RainbowEffect rainbow2(strip2, folded);
+    FrameTime time = nextFrame(BENCH_FRAME_MS);
+    rainbow1.update(time);
+    rainbow2.update(time);
+    CRGB scale = ws2812Adjustment(128, CRGB(TypicalLEDStrip));
+    runBench("WS2812 encode", [&](const FrameTime&) {
+      ws2812EncodeUart(strip1, STRIP_LEDS, scale, uart[0]);
+      ws2812EncodeUart(strip2, STRIP_LEDS, scale, uart[1]);
+      return true;
+    }, frames);
+  }
+
+  // Blending the outgoing and incoming effect into both strips, once per
+  // frame during a mode change crossfade
+  {
+    alignas(4) static CRGB outgoing[2][STRIP_LEDS];
+    resetState();
+    FireEffect fire1(outgoing[0], folded, false);
+    FireEffect fire2(outgoing[1], folded, true);
+    RainbowEffect rainbow1(strip1, folded);
+    RainbowEffect rainbow2(strip2, folded);
+    uint16_t amount = 0;
+    for (int f = 0; f < 20; f++) {
+      FrameTime time = nextFrame(BENCH_FRAME_MS);
+      fire1.update(time);
+      fire2.update(time);
+      rainbow1.update(time);
+      rainbow2.update(time);
+    }
+    runBench("Crossfade", [&](const FrameTime&) {
+      PowerEstimate power;
+      amount = (amount + 1) % CROSSFADE_FULL;
+      crossfadePixels(outgoing[0], strip1, strip1, STRIP_LEDS, amount, power);
+      crossfadePixels(outgoing[1], strip2, strip2, STRIP_LEDS, amount, power);
+      return true;
+    }, frames);
+  }
+
+  // Impact flash overlay composited over a running effect: fire underneath,
+  // a white add overlay and a screen overlay both mid-envelope
+  {
+    alignas(4) static CRGB base[2][STRIP_LEDS];
+    resetState();
+    FireEffect fire1(base[0], folded, false);
+    FireEffect fire2(base[1], folded, true);
+    Compositor compositor;
+    AlphaEnvelope envelope = { 0, 50, 50 };
+    runBench("Impact overlay", [&](const FrameTime& t) {
+      fire1.update(t);
+      fire2.update(t);
+      if (!compositor.begin(t.now)) {
+        compositor.add(CRGB(25, 25, 25), BLEND_ADD, envelope, t.now);
+        compositor.add(CRGB(0, 0, 64), BLEND_SCREEN, envelope, t.now);
+        compositor.begin(t.now);
+      }
+      PowerEstimate power;
+      compositor.apply(base[0], strip1, STRIP_LEDS, power);
+      compositor.apply(base[1], strip2, STRIP_LEDS, power);
+      return true;
+    }, frames);
+  }
+
+  if (!verifyWs2812Encoder()) {
+    return 1;
+  }
+  printf("\nWS2812 UART encoder round-trip OK\n");
+
+  if (!verifyCrossfade()) {
+    return 1;
+  }
+  printf("Crossfade matches the per-byte blend at all weights\n");
+
+  if (!verifyPowerEstimate()) {
+    return 1;
+  }
+  printf("Power estimate and brightness limit OK\n");
+
+  if (!verifyPaletteTables()) {
+    return 1;
+  }
+  printf("Flash palettes match HeatColor() and CHSV\n");
+
+  if (!verifyPovColumns()) {
+    return 1;
+  }
+  printf("POV columns match the per-pixel divide at every length\n");
+
+  if (!verifyRainbowHues()) {
+    return 1;
+  }
+  printf("Rainbow hues match the original map() ramps\n");
+
+  if (!verifyPulseWaves()) {
+    return 1;
+  }
+  printf("Pulse waves match the per-pixel sum for 1-%d waves on every layout\n", PULSE_MAX_WAVES);
+
+  if (!verifyHeatKernel()) {
+    return 1;
+  }
+  printf("Fire heat kernels match the per-cell loops\n");
+
+  if (!verifyEffectResume()) {
+    return 1;
+  }
+  printf("Effects carry on from their saved state\n");
+
+  bool rateOk = checkFrameRate("Fire", fireFrameAt);
+  rateOk &= checkFrameRate("Solid Color", lineFrameAt<SolidEffect>);
+  rateOk &= checkFrameRate("Energy Pulse", lineFrameAt<PulseEffect>);
+  rateOk &= checkFrameRate("Rainbow", lineFrameAt<RainbowEffect>);
+  rateOk &= checkFrameRate("Strobe", lineFrameAt<StrobeEffect>);
+  if (!rateOk) {
+    return 1;
+  }
+  printf("Effects are frame-rate independent (%lu ms at ", RATE_CHECK_MS);
+  for (unsigned long frameMs : RATE_CHECK_INTERVALS) {
+    printf("%s%lu", frameMs == RATE_CHECK_INTERVALS[0] ? "" : "/", frameMs);
+  }
+  printf(" ms frames)\n");
+
+  // Host pointer sizes make the effect arena larger than on the ESP8266
+  printf("\nStatic RAM (host sizes):\n");
+  printRamBudget();
+
+  return 0;
+}
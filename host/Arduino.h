@@ -0,0 +1,87 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the Arduino core, used by the [env:native] build.
+// Only the pieces the effect headers touch are provided. Time is virtual:
+// millis()/micros() only move when the host program calls hostClockAdvance(),
+// so effect timing gates behave exactly as they would on the staff.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define vsnprintf_P vsnprintf
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define IRAM_ATTR
+
+#define HIGH 1
+#define LOW 0
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// Arduino defines min/max as macros; templates keep std headers usable
+// (by value: the parameters are locals, so no reference may be returned)
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type min(T a, U b) { return a < b ? a : b; }
+template <typename T, typename U>
+inline typename std::common_type<T, U>::type max(T a, U b) { return a > b ? a : b; }
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// Virtual clock
+unsigned long millis();
+unsigned long micros();
+void hostClockAdvance(unsigned long ms);
+void hostClockAdvanceMicros(unsigned long us);
+void hostClockReset();
+
+inline void yield() {}
+inline void delay(unsigned long ms) { hostClockAdvance(ms); }
+inline void delayMicroseconds(unsigned int us) { hostClockAdvanceMicros(us); }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Minimal Serial that writes to stdout
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 128; }
+  void flush() { fflush(stdout); }
+  size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+
+  size_t print(const char* s) { return fputs(s, stdout) == EOF ? 0 : strlen(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+
+  template <typename T>
+  size_t println(T v) { size_t n = print(v); return n + print('\n'); }
+  size_t println() { return print('\n'); }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,297 @@
+#ifndef HOST_FASTLED_H
+#define HOST_FASTLED_H
+
+// Host stand-in for the subset of FastLED used by the effects.
+// The math helpers follow FastLED's portable C implementations so the
+// cost profile (and the pseudo-random sequence) matches the firmware.
+
+#include <Arduino.h>
+
+// ---- lib8tion -------------------------------------------------------------
+
+extern uint16_t rand16seed;
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) {
+  unsigned int t = i + j;
+  return t > 255 ? 255 : (uint8_t)t;
+}
+
+inline uint8_t qsub8(uint8_t i, uint8_t j) {
+  int t = i - j;
+  return t < 0 ? 0 : (uint8_t)t;
+}
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) {
+  return (uint8_t)((((uint16_t)i) * (1 + (uint16_t)scale)) >> 8);
+}
+
+inline uint8_t scale8_video(uint8_t i, uint8_t scale) {
+  return (uint8_t)((((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0));
+}
+
+inline uint8_t random8() {
+  rand16seed = (uint16_t)((rand16seed * 2053) + 13849);
+  return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+
+inline uint8_t random8(uint8_t lim) {
+  uint8_t r = random8();
+  r = (uint8_t)((r * lim) >> 8);
+  return r;
+}
+
+inline uint8_t random8(uint8_t min, uint8_t lim) {
+  uint8_t delta = lim - min;
+  return random8(delta) + min;
+}
+
+inline uint16_t random16() {
+  rand16seed = (uint16_t)((rand16seed * 2053) + 13849);
+  return rand16seed;
+}
+
+inline void random16_set_seed(uint16_t seed) { rand16seed = seed; }
+inline uint16_t random16_get_seed() { return rand16seed; }
+
+inline uint8_t sin8(uint8_t theta) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+  uint8_t offset = theta;
+  if (theta & 0x40) {
+    offset = (uint8_t)255 - offset;
+  }
+  offset &= 0x3F;
+
+  uint8_t secoffset = offset & 0x0F;
+  if (theta & 0x40) ++secoffset;
+
+  uint8_t section = offset >> 4;
+  const uint8_t* p = b_m16_interleave + section * 2;
+  uint8_t b = p[0];
+  uint8_t m16 = p[1];
+  uint8_t mx = (uint8_t)((m16 * secoffset) >> 4);
+
+  int8_t y = (int8_t)(mx + b);
+  if (theta & 0x80) y = -y;
+  y += 128;
+  return (uint8_t)y;
+}
+
+typedef uint16_t accum88;
+
+inline uint16_t beat88(accum88 beats_per_minute_88, uint32_t timebase = 0) {
+  return (uint16_t)((((uint32_t)millis() - timebase) * beats_per_minute_88 * 280) >> 16);
+}
+
+inline uint16_t beat16(accum88 beats_per_minute, uint32_t timebase = 0) {
+  if (beats_per_minute < 256) beats_per_minute <<= 8;
+  return beat88(beats_per_minute, timebase);
+}
+
+inline uint8_t beat8(accum88 beats_per_minute, uint32_t timebase = 0) {
+  return beat16(beats_per_minute, timebase) >> 8;
+}
+
+inline uint8_t beatsin8(accum88 beats_per_minute, uint8_t lowest = 0, uint8_t highest = 255,
+                        uint32_t timebase = 0, uint8_t phase_offset = 0) {
+  uint8_t beat = beat8(beats_per_minute, timebase);
+  uint8_t beatsin = sin8(beat + phase_offset);
+  uint8_t rangewidth = highest - lowest;
+  uint8_t scaledbeat = scale8(beatsin, rangewidth);
+  return lowest + scaledbeat;
+}
+
+// ---- Pixel types ----------------------------------------------------------
+
+struct CHSV {
+  uint8_t hue;
+  uint8_t sat;
+  uint8_t val;
+
+  CHSV() : hue(0), sat(0), val(0) {}
+  CHSV(uint8_t ih, uint8_t is, uint8_t iv) : hue(ih), sat(is), val(iv) {}
+};
+
+struct CRGB;
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+
+struct CRGB {
+  union {
+    struct { uint8_t r; uint8_t g; uint8_t b; };
+    uint8_t raw[3];
+  };
+
+  typedef enum {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Green = 0x008000,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF
+  } HTMLColorCode;
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+  CRGB(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+  CRGB& operator=(const CHSV& rhs) { hsv2rgb_rainbow(rhs, *this); return *this; }
+
+  uint8_t& operator[](uint8_t x) { return raw[x]; }
+  const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+  CRGB& nscale8(uint8_t scaledown) {
+    uint16_t scale_fixed = scaledown + 1;
+    r = (uint8_t)((r * scale_fixed) >> 8);
+    g = (uint8_t)((g * scale_fixed) >> 8);
+    b = (uint8_t)((b * scale_fixed) >> 8);
+    return *this;
+  }
+
+  CRGB& nscale8_video(uint8_t scaledown) {
+    r = scale8_video(r, scaledown);
+    g = scale8_video(g, scaledown);
+    b = scale8_video(b, scaledown);
+    return *this;
+  }
+
+  CRGB& fadeToBlackBy(uint8_t fadefactor) { return nscale8(255 - fadefactor); }
+
+  bool operator==(const CRGB& rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+  bool operator!=(const CRGB& rhs) const { return !(*this == rhs); }
+};
+
+// Color correction presets (values as in FastLED's color.h)
+enum LEDColorCorrection {
+  TypicalSMD5050 = 0xFFB0F0,
+  TypicalLEDStrip = 0xFFB0F0,
+  UncorrectedColor = 0xFFFFFF
+};
+
+inline void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+  uint8_t hue = hsv.hue;
+  uint8_t sat = hsv.sat;
+  uint8_t val = hsv.val;
+
+  uint8_t offset = hue & 0x1F;
+  uint8_t offset8 = offset << 3;
+  uint8_t third = scale8(offset8, (256 / 3));
+  uint8_t r, g, b;
+
+  if (!(hue & 0x80)) {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) {
+        r = 255 - third; g = third; b = 0;            // R -> O
+      } else {
+        r = 171; g = 85 + third; b = 0;               // O -> Y
+      }
+    } else {
+      if (!(hue & 0x20)) {
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3));
+        r = 171 - twothirds; g = 170 + third; b = 0;  // Y -> G
+      } else {
+        r = 0; g = 255 - third; b = third;            // G -> A
+      }
+    }
+  } else {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) {
+        uint8_t twothirds = scale8(offset8, ((256 * 2) / 3));
+        r = 0; g = 171 - twothirds; b = 85 + twothirds; // A -> B
+      } else {
+        r = third; g = 0; b = 255 - third;            // B -> P
+      }
+    } else {
+      if (!(hue & 0x20)) {
+        r = 85 + third; g = 0; b = 171 - third;       // P -> K
+      } else {
+        r = 170 + third; g = 0; b = 85 - third;       // K -> R
+      }
+    }
+  }
+
+  if (sat != 255) {
+    if (sat == 0) {
+      r = 255; g = 255; b = 255;
+    } else {
+      uint8_t desat = 255 - sat;
+      desat = scale8_video(desat, desat);
+      uint8_t satscale = 255 - desat;
+      if (r) r = scale8(r, satscale) + 1;
+      if (g) g = scale8(g, satscale) + 1;
+      if (b) b = scale8(b, satscale) + 1;
+      r += desat; g += desat; b += desat;
+    }
+  }
+
+  if (val != 255) {
+    val = scale8_video(val, val);
+    if (val == 0) {
+      r = 0; g = 0; b = 0;
+    } else {
+      if (r) r = scale8(r, val) + 1;
+      if (g) g = scale8(g, val) + 1;
+      if (b) b = scale8(b, val) + 1;
+    }
+  }
+
+  rgb.r = r; rgb.g = g; rgb.b = b;
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+  return (uint8_t)(scale8(a, 255 - amountOfB) + scale8(b, amountOfB));
+}
+
+inline CRGB blend(const CRGB& p1, const CRGB& p2, uint8_t amountOfP2) {
+  return CRGB(blend8(p1.r, p2.r, amountOfP2), blend8(p1.g, p2.g, amountOfP2), blend8(p1.b, p2.b, amountOfP2));
+}
+
+inline CRGB HeatColor(uint8_t temperature) {
+  CRGB heatcolor;
+  uint8_t t192 = scale8_video(temperature, 191);
+  uint8_t heatramp = t192 & 0x3F;
+  heatramp <<= 2;
+
+  if (t192 & 0x80) {
+    heatcolor.r = 255; heatcolor.g = 255; heatcolor.b = heatramp;
+  } else if (t192 & 0x40) {
+    heatcolor.r = 255; heatcolor.g = heatramp; heatcolor.b = 0;
+  } else {
+    heatcolor.r = heatramp; heatcolor.g = 0; heatcolor.b = 0;
+  }
+  return heatcolor;
+}
+
+inline void fill_solid(CRGB* leds, int numToFill, const CRGB& color) {
+  for (int i = 0; i < numToFill; ++i) {
+    leds[i] = color;
+  }
+}
+
+// ---- Timers ---------------------------------------------------------------
+
+class CEveryNMillis {
+public:
+  uint32_t mPrevTrigger;
+  uint32_t mPeriod;
+
+  CEveryNMillis(uint32_t period) : mPrevTrigger(millis()), mPeriod(period) {}
+
+  bool ready() {
+    uint32_t now = millis();
+    if (now - mPrevTrigger >= mPeriod) {
+      mPrevTrigger = now;
+      return true;
+    }
+    return false;
+  }
+
+  operator bool() { return ready(); }
+};
+
+#define EVERY_N_MILLISECONDS(N) EVERY_N_MILLISECONDS_I(_CONCAT_EVERY(PER, __COUNTER__), N)
+#define EVERY_N_MILLISECONDS_I(NAME, N) static CEveryNMillis NAME(N); if (NAME)
+#define _CONCAT_EVERY(a, b) _CONCAT_EVERY_I(a, b)
+#define _CONCAT_EVERY_I(a, b) a##b
+
+#endif // HOST_FASTLED_H
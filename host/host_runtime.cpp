@@ -0,0 +1,31 @@
+#include <Arduino.h>
+#include <FastLED.h>
+
+// Backing state for the host stand-ins in Arduino.h / FastLED.h
+
+HostSerial Serial;
+
+// FastLED seeds its PRNG with this value on reset
+uint16_t rand16seed = 1337;
+
+static unsigned long hostMicros = 0;
+
+unsigned long millis() {
+  return hostMicros / 1000;
+}
+
+unsigned long micros() {
+  return hostMicros;
+}
+
+void hostClockAdvance(unsigned long ms) {
+  hostMicros += ms * 1000;
+}
+
+void hostClockAdvanceMicros(unsigned long us) {
+  hostMicros += us;
+}
+
+void hostClockReset() {
+  hostMicros = 0;
+}
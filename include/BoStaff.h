@@ -6,7 +6,11 @@
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
+#include "../src/version.h"
 #include "effects.h"
+#include "../src/Compositor.h"
+#include "../src/PowerLimiter.h"
+#include "../src/Logger.h"
 
 // Pin definitions - UPDATED ASSIGNMENTS
 #define LED_PIN_1 D3  // GPIO0 - First LED strip (was D1)
@@ -16,6 +20,7 @@
 // MPU6050 accelerometer pins (I2C) - Using default pins
 #define SDA_PIN   D2  // GPIO4 - Default I2C data pin
 #define SCL_PIN   D1  // GPIO5 - Default I2C clock pin
+#define MPU_INT_PIN D5  // GPIO14 - MPU6050 INT (data ready)
 
 // LED strip configuration
 #define NUM_LEDS_PER_STRIP 200
@@ -32,41 +37,287 @@ struct Config {
   uint16_t impactFlashDuration = 100;  // Duration of impact flash in ms
 };
 
+// Effect registry - owns the instances of the active effect only
+// Effects are looked up by EffectType, constructed on activation and
+// destroyed on the next mode change. Instances live in a static arena with
+// one slot per strip sized for the largest effect, so switching modes
+// never touches the heap.
+
+// Symmetric effects get a single instance that renders one hilt-to-tip line,
+// which LEDController fans out to both strips and both folds
+struct EffectDescriptor;
+
+class EffectRegistry {
+private:
+  CRGB* strips[NUM_STRIPS];
+  CRGB* line;
+  alignas(EFFECT_SLOT_ALIGN) uint8_t arena[NUM_STRIPS][EFFECT_SLOT_SIZE];
+  Effect* instances[NUM_STRIPS];
+  const EffectDescriptor* active;
+  bool fallbackActive;  // Construction failed, fill with the fallback color
+  uint8_t detail;       // Handed to every instance, see Effect::setDetail()
+  
+public:
+  EffectRegistry() : strips{nullptr, nullptr}, line(nullptr), instances{nullptr, nullptr},
+                     active(nullptr), fallbackActive(false), detail(255) {}
+  ~EffectRegistry() { release(); }
+  
+  void begin(CRGB* strip1, CRGB* strip2, CRGB* lineBuffer);
+  bool activate(uint8_t type);
+  void release();
+  bool update(const FrameTime& time);  // True if any LED buffer changed
+  bool rendersLine() const;  // True if the last update() drew into the line buffer
+  uint8_t activeType() const;  // NUM_EFFECTS if none
+  void setDetail(uint8_t level);  // Applies to the active instances and later ones
+  Effect* instance(uint8_t strip) const { return instances[strip]; }  // Null for line effects' second strip
+};
+
+// Background WS2812 output on UART1 (D4)
+// show() encodes the frame into one of two buffers and returns; a timer
+// interrupt keeps the UART FIFO fed while the next frame is rendered
+class AsyncLedOutput {
+public:
+  bool begin();
+  void show(const CRGB* pixels, uint16_t count, const CRGB& scale, bool preempt = false);  // The first count pixels
+  bool busy() const;
+  void waitIdle(bool preempt = false);  // With preempt the frame on the wire is cut short first
+};
+
+// Frame pacing limits - the interval adapts to the render+show cost in between
+#define FRAME_MIN_INTERVAL_US 10000  // 100 fps cap
+#define FRAME_MAX_INTERVAL_US 50000  // Never slower than the old fixed 20 fps
+#define FRAME_COST_HEADROOM 2        // Interval = cost x headroom, the rest is left for input and sensors
+
+// Central frame clock
+// Decides when the next frame is due, hands the frame time to the effects
+// and keeps interval statistics (reset by printStats())
+class FrameClock {
+private:
+  unsigned long lastFrameMicros;
+  unsigned long frameStartMicros;
+  unsigned long lastFrameMillis;
+  unsigned long targetInterval;  // us
+  unsigned long intervalFloor;   // Shortest interval allowed, raised by the quality governor
+  unsigned long frameCost;       // Smoothed render+show time, us
+  bool started;
+  
+  // Statistics since the last printStats()
+  unsigned long minInterval;
+  unsigned long maxInterval;
+  uint64_t intervalSum;
+  uint32_t frameCount;
+  uint32_t overruns;  // Frames that started more than half an interval late
+  
+public:
+  FrameClock() : lastFrameMicros(0), frameStartMicros(0), lastFrameMillis(0),
+                 targetInterval(FRAME_MAX_INTERVAL_US), intervalFloor(FRAME_MIN_INTERVAL_US),
+                 frameCost(0), started(false) { resetStats(); }
+  
+  bool due() const;          // True once the next frame should be rendered
+  FrameTime beginFrame();    // Call right before rendering
+  void endFrame(unsigned long transientMicros = 0);  // Call after show(), adapts the interval to the cost
+  
+  unsigned long getTargetInterval() const { return targetInterval; }
+  unsigned long nextFrameMicros() const { return lastFrameMicros + targetInterval; }  // micros() the next frame is due
+  unsigned long getFrameCost() const { return frameCost; }
+  void setMinInterval(unsigned long intervalUs);  // Frame rate cap, FRAME_MIN_INTERVAL_US..FRAME_MAX_INTERVAL_US
+  void resetStats();
+  void printStats();
+};
+
+// Impact-to-photon timestamps (micros()) along the impact fast path
+struct ImpactTiming {
+  unsigned long sampleMicros;     // The sample over the threshold was taken
+  unsigned long detectMicros;     // Detection saw it
+  unsigned long showStartMicros;  // Flash output started
+  unsigned long showEndMicros;    // Strip 1 written; strip 2 finishes in the background about then
+};
+
+#define LATENCY_BUCKETS 16       // The last bucket is open-ended
+#define LATENCY_BUCKET_US 1000
+
+// Impact latency histogram (sample to show end) with per-stage averages,
+// printed over serial with the 'l' command
+class ImpactLatency {
+private:
+  uint16_t histogram[LATENCY_BUCKETS];
+  uint32_t count;
+  unsigned long maxTotal;
+  uint64_t detectSum;     // Stage sums, each measured from the sample
+  uint64_t showStartSum;
+  uint64_t showEndSum;
+  
+public:
+  ImpactLatency() { reset(); }
+  
+  void record(const ImpactTiming& timing);
+  void reset();
+  void print();  // Prints and starts over
+};
+
+// Hot path profiler (PROFILER_ENABLED)
+// Stages are timed in CPU cycles with ESP.getCycleCount(). Every stage
+// run is added to per-stage counters and to a ring of the most recent
+// events, which dumps as a Chrome trace (chrome://tracing, Perfetto).
+// Time spent idling in yield() is only counted, not traced.
+enum ProfileStage {
+  PROFILE_ACCEL = 0,  // accelHandler.update()
+  PROFILE_EFFECTS,    // Effect update() and fan-out
+  PROFILE_SHOW,       // LEDController::show()
+  PROFILE_POV,        // POV column output
+  PROFILE_BUTTON,     // buttonHandler.handle()
+  PROFILE_POWER,      // powerManager.update()
+  PROFILE_STAGES,
+  PROFILE_IDLE = PROFILE_STAGES  // Waiting for the next frame
+};
+
+#if PROFILER_ENABLED
+
+class Profiler {
+private:
+  struct Event {
+    uint32_t start;   // Cycle count
+    uint32_t packed;  // Stage in the top 4 bits, duration in cycles below (3.3 s max at 80 MHz)
+  };
+  
+  Event ring[PROFILER_RING_SIZE];
+  uint16_t ringHead;
+  uint16_t ringCount;
+  
+  // Summary since the last printSummary()
+  uint32_t runs[PROFILE_STAGES];
+  uint64_t cycles[PROFILE_STAGES];
+  uint32_t maxCycles[PROFILE_STAGES];
+  uint64_t idleCycles;
+  uint64_t loopCycles;
+  uint32_t loops;
+  uint32_t lastLoopStart;
+  
+public:
+  Profiler() : ringHead(0), ringCount(0), lastLoopStart(0) { resetSummary(); }
+  
+  void loopStart();
+  void record(ProfileStage stage, uint32_t start, uint32_t end);
+  void resetSummary();
+  void printSummary();  // Per-stage cycles and busy/idle share, then starts over
+  void dumpTrace();     // Chrome trace JSON of the ring, oldest first
+};
+
+extern Profiler profiler;
+
+// Times the enclosing scope as one stage run
+class ProfileScope {
+private:
+  ProfileStage stage;
+  uint32_t start;
+  
+public:
+  explicit ProfileScope(ProfileStage s) : stage(s), start(ESP.getCycleCount()) {}
+  ~ProfileScope() { profiler.record(stage, start, ESP.getCycleCount()); }
+};
+
+#define PROFILE_LOOP() profiler.loopStart()
+#define PROFILE_SCOPE(stage) ProfileScope profileScope(stage)
+
+#else
+
+#define PROFILE_LOOP()
+#define PROFILE_SCOPE(stage)
+
+#endif // PROFILER_ENABLED
+
 // LED Controller class
+// One effect and the buffers it renders into
+// The current mode's layer is copied to the strips; during a crossfade the
+// previous mode keeps running on the other layer and the two are blended.
+// Aligned for the word-wise crossfade kernel.
+struct EffectLayer {
+  alignas(4) CRGB strips[NUM_STRIPS][NUM_LEDS_PER_STRIP];
+  CRGB line[STAFF_LINE_LEDS];  // Hilt-to-tip render target for symmetric effects
+  EffectRegistry effects;
+};
+
 class LEDController {
 private:
-  CRGB leds1[NUM_LEDS_PER_STRIP];
-  CRGB leds2[NUM_LEDS_PER_STRIP];
+  alignas(4) CRGB leds1[NUM_LEDS_PER_STRIP];  // What the strips show
+  alignas(4) CRGB leds2[NUM_LEDS_PER_STRIP];
   Config* config;
+  EffectLayer layers[EFFECT_LAYERS];
+  uint8_t front;  // Layer of the current mode
+  Compositor compositor;  // Impact flash overlays on top of the layers
+  
+  // Current estimate of what's in the strips, summed while composing them
+  PowerEstimate power;
+  uint16_t powerBudget;     // mA, the brightness is limited to stay under it
+  uint32_t powerOutputs;    // Statistics since the last printPowerStats()
+  uint32_t powerLimited;
+  uint32_t powerSumMa;
+  uint32_t powerMaxMa;
+#if LED_OUTPUT_ASYNC
+  CLEDController* strip1Output;  // FastLED, bit-banged on D3
+  AsyncLedOutput strip2Output;   // UART1 on D4
+#endif
   uint8_t currentMode;
   unsigned long lastUpdate;
-  uint16_t effectStep;  // Moved up in declaration order to match constructor
   uint8_t effectSpeed;  // Moved up in declaration order to match constructor
   unsigned long impactEffectStart;  // Moved down in declaration order to match constructor
-  bool impactEffectActive;
+  bool impactEffectActive;  // The flash overlay is showing (POV columns pause)
   uint8_t normalBrightness; // Store normal brightness to restore after impact
+  bool frameDirty;          // Buffers changed since the last show()
+  bool stripsOverwritten;   // Strips hold something other than the front layer
+  uint8_t shownBrightness;  // Brightness of the last show()
+  
+  // Crossfade from the previous mode's layer
+  bool transitionsEnabled;  // Off at the lower quality levels, modes then cut
+  bool transitionActive;
+  unsigned long transitionStart;
+  unsigned long transitionCost;     // Extra time the last frame spent on it, us
+  unsigned long transitionCostMax;
+  uint32_t transitionCostSum;
+  uint16_t transitionFrames;
+  
+  // POV columns, output between frames while the staff spins
+  bool povSpinning;
+  int16_t povColumn;        // Last column sent for strip 1, -1 if none
+  uint32_t povColumns;      // Columns sent since the last printPovStats()
+  uint32_t povSkipped;      // Columns passed over because output couldn't keep up
   
-  // Effect functions
-  void updateFireEffect();
-  void updatePulseEffect();
-  void updateRainbowEffect();
-  void updateStrobeEffect();
-  void updateSolidEffect();
+  void output(uint16_t count, bool preempt);
+  void composeOverlays(bool fromLayer);
+  bool renderLayer(EffectLayer& layer, const FrameTime& time);
+  void composeTransition(const FrameTime& time);
+  void endTransition();
   
 public:
-  LEDController() : currentMode(0), lastUpdate(0), effectStep(0), effectSpeed(30), 
-                    impactEffectStart(0), impactEffectActive(false), normalBrightness(25) {}
+  LEDController() : front(0), powerBudget(LED_POWER_BUDGET_MA), powerOutputs(0), powerLimited(0),
+                    powerSumMa(0), powerMaxMa(0), currentMode(0), lastUpdate(0), effectSpeed(30), 
+                    impactEffectStart(0), impactEffectActive(false), normalBrightness(25),
+                    frameDirty(true), stripsOverwritten(true), shownBrightness(0),
+                    transitionsEnabled(true), transitionActive(false), transitionStart(0), transitionCost(0),
+                    transitionCostMax(0), transitionCostSum(0), transitionFrames(0),
+                    povSpinning(false), povColumn(-1), povColumns(0), povSkipped(0) {}
   
   void begin(Config* cfg);
-  void update();
+  bool update(const FrameTime& time);  // Returns false if the frame was unchanged and not sent
   void setMode(uint8_t mode);
   void triggerImpactEffect();
   void setBrightness(uint8_t brightness);
   void forceRefresh(); // New method to force a complete refresh of LED strips
+  void fill(const CRGB& color);     // Both strips one color, shown by the next show()
+  void show(bool preempt = false);  // Push the current buffers to the strips, preempt cuts short a strip 2 frame on the wire
+  void showImpact(ImpactTiming& timing);  // Impact fast path, fills in the show timestamps
+  
+  unsigned long getTransitionCost() const { return transitionCost; }  // Crossfade share of the last update(), us
+  void setQuality(uint8_t detail, bool transitions);  // Effect detail and mode crossfades, set by the quality governor
+  
+  uint16_t saveEffectState(uint8_t strip, uint8_t* state, uint16_t room) const;  // Shown effect's instance, kept across deep sleep
+  void restoreEffectState(uint8_t strip, const uint8_t* state, uint16_t length);
+  bool isPovMode() const { return layers[front].effects.activeType() == EFFECT_POV; }
+  void servicePov(bool spinning, uint32_t phase);  // Call every loop() in POV mode
+  void printPovStats();
   
-  // Getters for LED arrays
-  CRGB* getLeds1() { return leds1; }
-  CRGB* getLeds2() { return leds2; }
+  void setPowerBudget(uint16_t milliamps) { powerBudget = milliamps; }
+  void printPowerStats();
 };
 
 // Button handler class
@@ -89,38 +340,253 @@ public:
 };
 
 // Accelerometer handler class
+// With MPU_FIFO_SAMPLING the sensor samples into its FIFO at
+// MPU_SAMPLE_RATE_HZ and update() reads everything queued since the last
+// call in a few bursts, otherwise update() polls one reading per call
 class AccelerometerHandler {
 private:
   Adafruit_MPU6050 mpu;
   Config* config;
   bool mpuInitialized;
+  bool driverStarted;              // mpu.begin() done, start() skips it
+  unsigned long resetMillis;       // startReset() issued
   bool impactDetectedFlag;
   unsigned long lastImpactTime;
   unsigned long impactCooldown;
+  unsigned long lastRetryTime;     // Last attempt to bring a missing MPU back
+  
+  // Sampling hot path - integer only, registers read directly
+  bool fifoMode;
+  uint32_t thresholdSq;            // impactThreshold squared, in raw counts
+  uint16_t thresholdSqFor;         // impactThreshold that thresholdSq was computed from
+  unsigned long lastImpactMicros;  // Timestamp of the sample that triggered the last impact
+  unsigned long detectMicros;      // When that sample was checked
+  uint32_t lastImpactMagSq;
+  uint16_t lastBatchSize;          // Samples read by the last update()
+  uint8_t sampleBytes;             // FIFO bytes per sample, 8 while tracking spin
+  uint16_t sampleRateHz;           // FIFO sample rate in use
+  uint16_t requestedRateHz;        // Rate asked for by the quality governor, kept across MPU restarts
+  unsigned long samplePeriodUs;
+  
+  // Spin phase for POV mode, integrated from the gyro (FIFO mode only)
+  uint32_t spinPhase;              // Binary angle, 2^32 per turn, no absolute reference
+  int32_t spinRate;                // Phase per sample period over the last batch
+  int32_t gyroBiasQ8;              // Spin axis gyro offset, counts x 256
+  unsigned long spinMicros;        // When the newest integrated sample was taken
+  bool spinning;
+  
+  // Statistics since the last printStats()
+  uint32_t sampleCount;
+  uint32_t readMicros;
+  uint32_t fifoOverflows;
+  
+  bool beginFifo();
+  void applySampleRate(uint16_t rateHz);
+  void resetFifo();
+  uint32_t readFifo(bool detectImpacts);
+  void updatePolled();
+  void checkImpact(uint32_t magSq, unsigned long sampleMicros);
+  void updateSpin(int32_t gyroSum, uint16_t samples, unsigned long newestMicros);
+  void updateThreshold();
+  uint16_t magnitudeUnits(uint32_t magSq);
+  bool readRegisters(uint8_t reg, uint8_t* buffer, uint8_t length);
+  void writeRegister(uint8_t reg, uint8_t value);
   
   // Helper method for calibration
   void waitForButtonPress();
   
 public:
-  AccelerometerHandler() : mpuInitialized(false), impactDetectedFlag(false), 
-                           lastImpactTime(0), impactCooldown(500) {}
+  AccelerometerHandler() : mpuInitialized(false), driverStarted(false), resetMillis(0), impactDetectedFlag(false), 
+                           lastImpactTime(0), impactCooldown(500), lastRetryTime(0), fifoMode(false),
+                           thresholdSq(0xFFFFFFFF), thresholdSqFor(0), lastImpactMicros(0),
+                           detectMicros(0), lastImpactMagSq(0),
+                           lastBatchSize(0), sampleBytes(6), sampleRateHz(MPU_SAMPLE_RATE_HZ),
+                           requestedRateHz(MPU_SAMPLE_RATE_HZ),
+                           samplePeriodUs(1000000UL / MPU_SAMPLE_RATE_HZ), spinPhase(0), spinRate(0), gyroBiasQ8(0),
+                           spinMicros(0), spinning(false), sampleCount(0), readMicros(0), fifoOverflows(0) {}
   
   bool begin(Config* cfg);
+  void startReset(Config* cfg);   // Boot start without blocking: reset,
+  bool resetDone() const;         // wait for this,
+  bool start(Config* cfg, int32_t gyroBias);  // then start (straight away after a motion wake)
+  bool armMotionWake();   // Motion detection only, before deep sleep
+  bool motionLatched();   // Motion seen since armMotionWake(), clears it
+  int32_t getGyroBias() const { return gyroBiasQ8; }
   void update();
   bool impactDetected();
   void calibrate();
+  
+  unsigned long getImpactMicros() const { return lastImpactMicros; }
+  unsigned long getDetectMicros() const { return detectMicros; }
+  void printImpact();  // Log the last impact, kept off the fast path
+  uint16_t getLastBatchSize() const { return lastBatchSize; }
+  
+  void setSpinTracking(bool enabled);  // Add the gyro to the FIFO for POV mode
+  bool isSpinning() const { return spinning; }
+  uint32_t getSpinPhase(unsigned long nowMicros) const;
+  void setSampleRate(uint16_t rateHz);  // Applied in FIFO mode, now or when the MPU next starts
+  uint16_t getSampleRate() const { return sampleRateHz; }
+  void printStats();
+};
+
+// Quality levels, each trading detail for battery life and CPU time
+enum QualityLevel {
+  QUALITY_FULL,
+  QUALITY_REDUCED,
+  QUALITY_ECO,
+  QUALITY_MINIMAL,
+  QUALITY_LEVELS
+};
+
+// What a quality level allows
+struct QualityProfile {
+  const char* name;
+  unsigned long frameIntervalUs;  // Frame rate cap
+  uint8_t effectDetail;           // Effect::setDetail()
+  uint16_t sensorRateHz;          // MPU FIFO sample rate
+  bool transitions;               // Mode changes crossfade
+};
+
+// Adaptive quality governor
+// Picks the quality level from the battery voltage and the measured frame
+// cost (whichever asks for less) and applies it to the frame clock, the
+// effects and the accelerometer. Printed over serial with the 'q' command.
+class QualityGovernor {
+private:
+  FrameClock* clock;
+  LEDController* leds;
+  AccelerometerHandler* accel;
+  QualityLevel level;          // Applied level, the lower of the two below
+  QualityLevel batteryLevel;
+  QualityLevel loadLevel;
+  uint8_t overBudget;          // Consecutive checks over the frame budget
+  uint8_t underBudget;         // Consecutive checks with headroom
+  unsigned long lastCheck;
+  unsigned long levelSince;    // millis() the applied level was entered
+  uint32_t levelMillis[QUALITY_LEVELS];  // Time spent at each level, not counting the current stretch
+  uint32_t changes;
+  float lastVoltage;
+  
+  void apply(QualityLevel newLevel, const char* reason);
+  
+public:
+  QualityGovernor() : clock(nullptr), leds(nullptr), accel(nullptr), level(QUALITY_FULL),
+                      batteryLevel(QUALITY_FULL), loadLevel(QUALITY_FULL), overBudget(0), underBudget(0),
+                      lastCheck(0), levelSince(0), levelMillis{0, 0, 0, 0}, changes(0), lastVoltage(0) {}
+  
+  void begin(FrameClock* frameClock, LEDController* ledController, AccelerometerHandler* accelerometer);
+  void update(float batteryVoltage);  // Call from loop(), checks every GOVERNOR_CHECK_MS
+  QualityLevel getLevel() const { return level; }
+  void print();
+};
+
+// CPU and radio power states
+// The radio is never used, so it stays off from reset. Between frames the
+// CPU halts until the next deadline instead of spinning in loop(); any
+// interrupt (button edge, MPU data ready, serial, LED output) ends the
+// sleep early. Awake time is printed with the frame statistics.
+class PowerState {
+private:
+  unsigned long windowStart;  // Statistics since the last printStats()
+  uint32_t sleptMicros;
+  uint32_t sleeps;
+  uint32_t earlyWakes;        // Woken before the deadline
+  
+public:
+  PowerState() : windowStart(0), sleptMicros(0), sleeps(0), earlyWakes(0) {}
+  
+  void begin();
+  void sleepUntil(unsigned long deadlineMicros);  // Returns at the deadline or the first interrupt
+  void printStats();
+};
+
+// Deep sleep with wake on motion
+// Before sleeping the settings, gyro bias and the effect's animation state
+// go into RTC memory, which survives deep sleep, and the MPU is left
+// detecting motion. With SLEEP_WAKE_ON_INT its latched interrupt resets
+// the board; either way the timer wakes it every SLEEP_WAKE_CHECK_MS and
+// it goes straight back to sleep unless the MPU saw motion. setup() then
+// resumes from the RTC copy instead of loading settings and starting the
+// MPU from scratch.
+class SleepState {
+private:
+  Config* config;
+  AccelerometerHandler* accel;
+  LEDController* leds;
+  bool resumed;
+  uint32_t checks;    // Wake checks before the motion that resumed
+  int32_t gyroBias;
+  
+public:
+  SleepState() : config(nullptr), accel(nullptr), leds(nullptr), resumed(false), checks(0), gyroBias(0) {}
+  
+  bool begin(Config* cfg, AccelerometerHandler* accelerometer, LEDController* ledController);  // First thing in setup(), true when resuming
+  void restoreEffects();  // After the resumed mode is activated, before its first frame
+  void enter();  // Does not return
+  bool isResumed() const { return resumed; }
+  uint32_t getChecks() const { return checks; }
+  int32_t getGyroBias() const { return gyroBias; }
+};
+
+// Startup stages, in the order they finish
+// setup() gets the saved effect on the strips first; the rest runs from
+// loop() one stage at a time between frames
+enum BootStage {
+  BOOT_SERIAL,       // Serial up, radio off
+  BOOT_SETTINGS,     // Settings loaded, or restored after a sleep
+  BOOT_FIRST_LIGHT,  // First frame of the saved effect shown
+  BOOT_SENSOR,       // MPU sampling
+  BOOT_STORAGE,      // Settings journal ready for saves
+  BOOT_POWER,        // Sleep timer and quality governor started (battery read before first light)
+  BOOT_DIAGNOSTICS,  // Banner and RAM budget printed, a line per pass
+  BOOT_STAGES
+};
+
+// Time from reset to first light that the boot report warns about
+#define BOOT_FIRST_LIGHT_BUDGET_MS 200
+
+// Boot timestamps, printed once the boot is done and with the 'b' command
+class BootProfile {
+private:
+  unsigned long stageMicros[BOOT_STAGES];  // micros() since reset when each stage finished
+  uint8_t finished;                        // Stages finished so far
+  
+public:
+  BootProfile() : finished(0) {}
+  
+  void mark(BootStage stage);
+  BootStage next() const { return (BootStage)finished; }
+  bool done() const { return finished == BOOT_STAGES; }
+  void print();
 };
 
 // Settings manager class for storing configuration in flash
+// Write-behind journal on LittleFS, see SettingsManager.cpp
 class SettingsManager {
 private:
-  // EEPROM address where settings are stored
-  const int configAddress = 0;
+  Config* config;
+  bool fsReady;
+  bool dirty;                // saveSettings() called since the last write
+  unsigned long lastChange;  // millis() of the last saveSettings()
+  uint32_t sequence;         // Newest record written or loaded
+  uint8_t journalFile;       // Journal file the next record is appended to
+  uint16_t journalRecords;   // Records in it
+  Config written;            // Settings in the newest record
+  
+  bool loadJournal(Config* cfg);
+  bool loadLegacy(Config* cfg);
+  bool writeRecord(const Config* cfg);
   
 public:
+  SettingsManager() : config(nullptr), fsReady(false), dirty(false), lastChange(0),
+                      sequence(0), journalFile(0), journalRecords(0) {}
+  
   void begin();
   bool loadSettings(Config* cfg);
-  void saveSettings(Config* cfg);
+  void resume(Config* cfg);        // Settings came from RTC memory, only find the journal position
+  void saveSettings(Config* cfg);  // Deferred until the settings have been quiet for a while
+  void update();                   // Call from loop(), writes a deferred save when due
+  void flush();                    // Write a deferred save now
 };
 
 #endif // BOSTAFF_H
\ No newline at end of file
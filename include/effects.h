@@ -2,10 +2,13 @@
 #define EFFECTS_H
 
 // Include all effect implementations
+#include "../src/Effects/Effect.h"
+#include "../src/Effects/SolidEffect.h"
 #include "../src/Effects/FireEffect.h"
 #include "../src/Effects/PulseEffect.h"
 #include "../src/Effects/RainbowEffect.h"
 #include "../src/Effects/StrobeEffect.h"
+#include "../src/Effects/PovEffect.h"
 
 // Effect type enum for better code readability
 enum EffectType {
@@ -14,9 +17,35 @@ enum EffectType {
   EFFECT_PULSE = 2,
   EFFECT_RAINBOW = 3,
   EFFECT_STROBE = 4,
+  EFFECT_POV = 5,
   NUM_EFFECTS
 };
 
+// Largest size and alignment among the given types
+template <typename T>
+constexpr size_t largestSize() { return sizeof(T); }
+
+template <typename T, typename Next, typename... Rest>
+constexpr size_t largestSize() {
+  return sizeof(T) > largestSize<Next, Rest...>() ? sizeof(T) : largestSize<Next, Rest...>();
+}
+
+template <typename T>
+constexpr size_t largestAlign() { return alignof(T); }
+
+template <typename T, typename Next, typename... Rest>
+constexpr size_t largestAlign() {
+  return alignof(T) > largestAlign<Next, Rest...>() ? alignof(T) : largestAlign<Next, Rest...>();
+}
+
+// One slot of the registry's static arena holds any effect instance
+// (a new effect has to be added to both lists)
+constexpr size_t EFFECT_SLOT_ALIGN = largestAlign<SolidEffect, FireEffect, PulseEffect,
+                                                  RainbowEffect, StrobeEffect, PovEffect>();
+constexpr size_t EFFECT_SLOT_SIZE = (largestSize<SolidEffect, FireEffect, PulseEffect,
+                                                 RainbowEffect, StrobeEffect, PovEffect>()
+                                     + EFFECT_SLOT_ALIGN - 1) / EFFECT_SLOT_ALIGN * EFFECT_SLOT_ALIGN;
+
 // Helper struct to store effect parameters
 struct EffectParams {
   uint8_t brightness = 25;  // Reduced from 150 to 25 (~10%)
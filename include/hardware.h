@@ -6,6 +6,7 @@
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
+#include "BoStaff.h"
 
 // Project version and build info
 #include "../src/version.h"
@@ -29,23 +30,34 @@ private:
   unsigned long lastActiveTime;
   bool lowBatteryMode;
   float batteryVoltage;
-  uint8_t originalBrightness;
   unsigned long lastBatteryCheck;  // Added to control battery check interval
+  LEDController* leds;             // Used for the fade out before sleeping
+  SettingsManager* settings;       // Flushed before sleeping
+  SleepState* sleepState;          // Keeps the state and wakes on motion
   const unsigned long BATTERY_CHECK_INTERVAL = 10000;  // Increased to check battery every 10 seconds
   
 public:
   PowerManager() : lastActiveTime(0), lowBatteryMode(false), batteryVoltage(0.0), 
-                   originalBrightness(255), lastBatteryCheck(0) {}
+                   lastBatteryCheck(0), leds(nullptr), settings(nullptr), sleepState(nullptr) {}
   
-  void begin() {
-    // Initialize power management
-    lastActiveTime = millis();
-    lastBatteryCheck = millis();
-    batteryVoltage = readBatteryVoltage();
-    lowBatteryMode = (batteryVoltage < BATTERY_MIN_VOLTAGE);
+  // Read the battery and set the LED current budget to suit, before the
+  // first frame so a low battery never sees the full budget
+  void beginBattery(LEDController* ledController) {
+    leds = ledController;
     
     // Set up pins for power monitoring
     pinMode(BATTERY_PIN, INPUT);
+    lastBatteryCheck = millis();
+    batteryVoltage = readBatteryVoltage();
+    lowBatteryMode = (batteryVoltage < BATTERY_MIN_VOLTAGE);
+    leds->setPowerBudget(lowBatteryMode ? LED_POWER_BUDGET_LOW_MA : LED_POWER_BUDGET_MA);
+  }
+  
+  void begin(SettingsManager* settingsManager, SleepState* sleep) {
+    // Initialize power management (the battery was read by beginBattery())
+    settings = settingsManager;
+    sleepState = sleep;
+    lastActiveTime = millis();
   }
   
   float readBatteryVoltage() {
@@ -66,34 +78,35 @@ public:
       // Check for low battery condition
       if (batteryVoltage < BATTERY_MIN_VOLTAGE && !lowBatteryMode) {
         lowBatteryMode = true;
-        originalBrightness = FastLED.getBrightness();
-        // Reduce brightness to conserve power
-        FastLED.setBrightness(originalBrightness / 2);
-        Serial.println("Low battery mode activated");
+        // Lower the LED current budget, bright frames get dimmed to fit
+        leds->setPowerBudget(LED_POWER_BUDGET_LOW_MA);
+        LOG_WARN("Low battery mode activated");
       } else if (batteryVoltage > (BATTERY_MIN_VOLTAGE + 0.2) && lowBatteryMode) {
         // Restore normal operation when voltage is back up
         lowBatteryMode = false;
-        FastLED.setBrightness(originalBrightness);
-        Serial.println("Normal power mode restored");
+        leds->setPowerBudget(LED_POWER_BUDGET_MA);
+        LOG_INFO("Normal power mode restored");
       }
     }
     
     // Check for inactivity timeout
     if (POWER_SAVING_MODE && (millis() - lastActiveTime > SLEEP_AFTER_MINS * 60000)) {
       // Enter sleep mode to save power
-      Serial.println("Entering sleep mode");
-      // Save any unsaved settings here
+      LOG_INFO("Entering sleep mode");
+      // Save any unsaved settings
+      settings->flush();
       
       // Fade LEDs to black
       uint8_t originalBrightness = FastLED.getBrightness();
       for (int i = originalBrightness; i >= 0; i--) {
         FastLED.setBrightness(i);
-        FastLED.show();
+        leds->show();
         delay(20);
       }
       
-      // Put ESP into deep sleep
-      ESP.deepSleep(0);
+      // Put ESP into deep sleep until the staff is picked up
+      logger.flush();
+      sleepState->enter();
     }
   }
   
@@ -1,5 +1,239 @@
 #include "BoStaff.h"
 
+// MPU6050 registers for the sampling hot path - setup and calibration go
+// through the Adafruit library, samples are read straight from the chip
+#define MPU_ADDR             0x68
+#define MPU_REG_SMPLRT_DIV   0x19
+#define MPU_REG_CONFIG       0x1A
+#define MPU_REG_GYRO_CONFIG  0x1B
+#define MPU_REG_ACCEL_CONFIG 0x1C
+#define MPU_REG_MOT_THR      0x1F
+#define MPU_REG_MOT_DUR      0x20
+#define MPU_REG_INT_PIN_CFG  0x37
+#define MPU_REG_INT_ENABLE   0x38
+#define MPU_REG_INT_STATUS   0x3A
+#define MPU_REG_PWR_MGMT_1   0x6B
+#define MPU_REG_PWR_MGMT_2   0x6C
+#define MPU_REG_FIFO_EN      0x23
+#define MPU_REG_USER_CTRL    0x6A
+#define MPU_REG_FIFO_COUNT_H 0x72
+#define MPU_REG_FIFO_R_W     0x74
+#define MPU_REG_ACCEL_XOUT_H 0x3B
+
+#define MPU_FIFO_EN_ACCEL    0x08
+#define MPU_FIFO_EN_GYRO_X   0x40  // Y and Z follow in the next two bits down
+#define MPU_USER_FIFO_EN     0x40
+#define MPU_USER_FIFO_RESET  0x04
+#define MPU_INT_DATA_RDY     0x01
+#define MPU_INT_MOTION       0x40
+#define MPU_DLPF_184_HZ      1
+#define MPU_DLPF_94_HZ       2
+#define MPU_DLPF_21_HZ       4
+#define MPU_ACCEL_16_G       0x18
+#define MPU_GYRO_2000_DPS    0x18
+#define MPU_ACCEL_HPF_5_HZ   0x01
+#define MPU_INT_LATCH        0x20  // INT held until INT_STATUS is read
+#define MPU_PWR_RESET        0x80
+#define MPU_PWR_CLOCK_GYRO_X 0x01
+#define MPU_PWR_CYCLE        0x20
+#define MPU_PWR_TEMP_OFF     0x08
+#define MPU_PWR_GYRO_STANDBY 0x07
+#define MPU_LP_WAKE_20_HZ    0x80
+
+// Motion wake while the board sleeps: the accel alone samples at 20 Hz and
+// latches the interrupt once a reading changes by more than the threshold
+// (in 2 mg steps) from the high-passed baseline
+#define MPU_MOTION_THRESHOLD 20
+#define MPU_MOTION_DURATION 1
+
+#define MPU_FIFO_SIZE 1024
+#define MPU_ACCEL_BYTES 6    // Accel X, Y, Z, big endian
+#define MPU_SPIN_BYTES 8     // Accel plus the spin axis gyro, in register order
+#define MPU_BURST_BYTES 120  // Per read, within the 128 byte Wire buffer
+
+// Gyro at the 2000 dps range is 16.4 counts per dps. Phase is a binary
+// angle (2^32 per turn), so one count held for one sample period turns
+// the phase by 2^32 / (16.4 * 360 * rate); this is that in Q8.
+static uint32_t phasePerCountQ8(uint16_t rateHz) {
+  return (uint32_t)((1ULL << 40) * 10 / (164ULL * 360 * rateHz));
+}
+#define GYRO_COUNTS_PER_DPS_Q4 262  // 16.4 x 16
+#define SPIN_START_COUNTS ((int32_t)POV_MIN_SPIN_DPS * GYRO_COUNTS_PER_DPS_Q4 / 16)
+#define SPIN_STOP_COUNTS (SPIN_START_COUNTS / 2)
+#define GYRO_STILL_COUNTS 50        // Below ~3 dps the staff is taken as still and the bias tracked
+#define SPIN_EXTRAPOLATE_US 20000   // Never run the phase on further than this past the last sample
+
+// Raw counts at the 16G range are 2048 per g; thresholds are in m/s^2 x 100,
+// so one threshold unit is 2.0884 counts (34216 / 2^14)
+#define ACCEL_UNITS_PER_COUNT (980.665f / 2048.0f)
+#define COUNTS_PER_UNIT_Q14 34216
+
+// Fast mode; the MPU6050 supports up to 400 kHz
+#define MPU_I2C_CLOCK 400000
+
+// How often update() tries to bring back an MPU that failed to start
+#define MPU_RETRY_INTERVAL_MS 5000
+
+// Device reset to registers usable again (the driver waits the same)
+#define MPU_RESET_MS 100
+
+// Set by the data-ready interrupt: the time the newest sample was taken
+static volatile unsigned long dataReadyMicros = 0;
+static volatile uint32_t dataReadyCount = 0;
+
+static void IRAM_ATTR onDataReady() {
+  dataReadyMicros = micros();
+  dataReadyCount++;
+}
+
+void AccelerometerHandler::writeRegister(uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(MPU_ADDR);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+bool AccelerometerHandler::readRegisters(uint8_t reg, uint8_t* buffer, uint8_t length) {
+  Wire.beginTransmission(MPU_ADDR);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) {
+    return false;
+  }
+  if (Wire.requestFrom((uint8_t)MPU_ADDR, (size_t)length) != length) {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    buffer[i] = Wire.read();
+  }
+  return true;
+}
+
+// Squared magnitude of a big endian X/Y/Z sample in raw counts
+// Each square fits in 31 bits, the sum needs all 32
+static inline uint32_t squaredMagnitude(const uint8_t* p) {
+  int32_t x = (int16_t)((p[0] << 8) | p[1]);
+  int32_t y = (int16_t)((p[2] << 8) | p[3]);
+  int32_t z = (int16_t)((p[4] << 8) | p[5]);
+  return (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);
+}
+
+void AccelerometerHandler::resetFifo() {
+  writeRegister(MPU_REG_USER_CTRL, 0);
+  writeRegister(MPU_REG_USER_CTRL, MPU_USER_FIFO_RESET);
+  writeRegister(MPU_REG_USER_CTRL, MPU_USER_FIFO_EN);
+}
+
+/**
+ * Queue the spin axis gyro in the FIFO alongside the accel (POV mode) or not
+ * The FIFO is restarted so it never holds a mix of sample sizes
+ */
+void AccelerometerHandler::setSpinTracking(bool enabled) {
+  if (!fifoMode || enabled == (sampleBytes == MPU_SPIN_BYTES)) {
+    return;
+  }
+  
+  sampleBytes = enabled ? MPU_SPIN_BYTES : MPU_ACCEL_BYTES;
+  writeRegister(MPU_REG_FIFO_EN, MPU_FIFO_EN_ACCEL | (enabled ? (MPU_FIFO_EN_GYRO_X >> MPU_SPIN_AXIS) : 0));
+  resetFifo();
+  spinning = false;
+  spinRate = 0;
+  
+  LOG_INFO("Gyro spin tracking %s", enabled ? "on" : "off");
+}
+
+/**
+ * Phase at the given time, run on from the last sample at the measured rate
+ */
+uint32_t AccelerometerHandler::getSpinPhase(unsigned long nowMicros) const {
+  unsigned long elapsed = nowMicros - spinMicros;
+  if (elapsed > SPIN_EXTRAPOLATE_US) {
+    elapsed = SPIN_EXTRAPOLATE_US;
+  }
+  return spinPhase + (uint32_t)(((int64_t)spinRate * (int32_t)elapsed) / (int32_t)samplePeriodUs);
+}
+
+/**
+ * Integrate a batch of spin axis gyro samples into the phase
+ * gyroSum is the raw count total over samples readings, the newest taken
+ * at newestMicros. Spinning switches on and off with hysteresis, and the
+ * gyro bias is learned whenever the staff is still.
+ */
+void AccelerometerHandler::updateSpin(int32_t gyroSum, uint16_t samples, unsigned long newestMicros) {
+  // Bias removed, still in counts x samples (128 samples x 32768 fits easily)
+  int32_t sumQ8 = gyroSum * 256 - gyroBiasQ8 * samples;
+  uint32_t phasePerCount = phasePerCountQ8(sampleRateHz);
+  spinPhase += (uint32_t)(((int64_t)sumQ8 * phasePerCount) >> 16);
+  spinRate = (int32_t)(((int64_t)sumQ8 * phasePerCount / samples) >> 16);
+  spinMicros = newestMicros;
+  
+  int32_t rateCounts = sumQ8 / samples / 256;
+  int32_t absRate = rateCounts < 0 ? -rateCounts : rateCounts;
+  if (absRate >= SPIN_START_COUNTS) {
+    spinning = true;
+  } else if (absRate < SPIN_STOP_COUNTS) {
+    spinning = false;
+  }
+  
+  if (absRate < GYRO_STILL_COUNTS) {
+    gyroBiasQ8 += (sumQ8 / samples) / 16;
+  }
+}
+
+/**
+ * Program the FIFO sample rate (1000 Hz divided by a whole number)
+ */
+void AccelerometerHandler::applySampleRate(uint16_t rateHz) {
+  // The 21 Hz filter would smear short peaks, so widen it to suit the rate
+  // (written directly: start() doesn't start the driver)
+  writeRegister(MPU_REG_CONFIG, rateHz >= 1000 ? MPU_DLPF_184_HZ : MPU_DLPF_94_HZ);
+  
+  // With the filter on the sample clock is 1 kHz
+  writeRegister(MPU_REG_SMPLRT_DIV, 1000 / rateHz - 1);
+  
+  // The extrapolation rate is per sample period, keep it per microsecond
+  spinRate = (int32_t)((int64_t)spinRate * sampleRateHz / rateHz);
+  sampleRateHz = rateHz;
+  samplePeriodUs = 1000000UL / rateHz;
+}
+
+/**
+ * Change the FIFO sample rate at runtime (quality governor)
+ * The rate is remembered so an MPU restart comes back at it. Samples
+ * already queued were taken at the old rate, so they're dropped
+ */
+void AccelerometerHandler::setSampleRate(uint16_t rateHz) {
+  if (rateHz == 0 || rateHz > 1000) {
+    return;
+  }
+  requestedRateHz = rateHz;
+  if (!mpuInitialized || !fifoMode || rateHz == sampleRateHz) {
+    return;
+  }
+  applySampleRate(rateHz);
+  resetFifo();
+  LOG_INFO("Accelerometer FIFO sampling at %u Hz", rateHz);
+}
+
+/**
+ * Sample accel X/Y/Z into the FIFO and pulse INT for every sample
+ */
+bool AccelerometerHandler::beginFifo() {
+  applySampleRate(requestedRateHz);
+  
+  writeRegister(MPU_REG_INT_PIN_CFG, 0);  // Active high, push-pull, 50 us pulse
+  writeRegister(MPU_REG_INT_ENABLE, MPU_INT_DATA_RDY);
+  writeRegister(MPU_REG_FIFO_EN, MPU_FIFO_EN_ACCEL);
+  sampleBytes = MPU_ACCEL_BYTES;
+  resetFifo();
+  
+  pinMode(MPU_INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(MPU_INT_PIN), onDataReady, RISING);
+  
+  Serial.print("Accelerometer FIFO sampling at "); Serial.print(sampleRateHz);
+  Serial.println(" Hz");
+  return true;
+}
+
 bool AccelerometerHandler::begin(Config* cfg) {
   config = cfg;
   
@@ -8,107 +242,301 @@ bool AccelerometerHandler::begin(Config* cfg) {
   
   // Initialize the MPU6050
   if (!mpu.begin()) {
-    Serial.println("Failed to find MPU6050 chip");
+    LOG_ERROR("Failed to find MPU6050 chip");
     mpuInitialized = false;
     return false;
   }
+  driverStarted = true;
   
   // Configure the accelerometer - using 16G range for better impact detection
   mpu.setAccelerometerRange(MPU6050_RANGE_16_G); // Changed from 8G to 16G
-  mpu.setGyroRange(MPU6050_RANGE_500_DEG);
+  mpu.setGyroRange(MPU6050_RANGE_2000_DEG);  // A spinning staff passes 1000 dps
   mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
   
-  // Wait for the sensor to stabilize
-  delay(100);
+  Wire.setClock(MPU_I2C_CLOCK);
+  updateThreshold();
+  fifoMode = MPU_FIFO_SAMPLING && beginFifo();
   
+  // The driver already waited for the reset to settle
   mpuInitialized = true;
-  Serial.println("Accelerometer initialized with 16G range");
-  Serial.print("Impact threshold set to: ");
+  Serial.print("Accelerometer initialized with 16G range, impact threshold ");
   Serial.println(config->impactThreshold);
   
-  // Initial accelerometer reading to check functionality
-  sensors_event_t a, g, temp;
-  mpu.getEvent(&a, &g, &temp);
+  return true;
+}
+
+/**
+ * First half of a boot-time start that doesn't block: reset the MPU and
+ * note when. start() finishes it once resetDone() says it has settled.
+ */
+void AccelerometerHandler::startReset(Config* cfg) {
+  config = cfg;
+  Wire.begin(SDA_PIN, SCL_PIN);
+  Wire.setClock(MPU_I2C_CLOCK);
+  writeRegister(MPU_REG_PWR_MGMT_1, MPU_PWR_RESET);
+  resetMillis = millis();
+}
+
+bool AccelerometerHandler::resetDone() const {
+  return millis() - resetMillis >= MPU_RESET_MS;
+}
+
+/**
+ * Bring the MPU up by writing its registers directly, after startReset()
+ * or a motion wake (it stayed powered and configured through the sleep,
+ * so this only takes it out of cycle mode). No driver start and no
+ * settling delay. Returns false if it doesn't answer; begin() then does
+ * the full start.
+ */
+bool AccelerometerHandler::start(Config* cfg, int32_t gyroBias) {
+  config = cfg;
+  Wire.begin(SDA_PIN, SCL_PIN);
+  Wire.setClock(MPU_I2C_CLOCK);
   
-  Serial.println("Initial accelerometer readings:");
-  Serial.print("X: "); Serial.print(a.acceleration.x);
-  Serial.print(" Y: "); Serial.print(a.acceleration.y);
-  Serial.print(" Z: "); Serial.print(a.acceleration.z);
-  Serial.println(" m/s^2");
+  uint8_t status;
+  if (!readRegisters(MPU_REG_INT_STATUS, &status, 1)) {
+    return begin(cfg);
+  }
   
-  // Calculate and print magnitude
-  float accelMagnitude = sqrt(a.acceleration.x * a.acceleration.x + 
-                             a.acceleration.y * a.acceleration.y + 
-                             a.acceleration.z * a.acceleration.z);
-  Serial.print("Magnitude: "); Serial.print(accelMagnitude);
-  Serial.print(" m/s^2, Raw: "); Serial.println((uint16_t)(accelMagnitude * 100));
+  writeRegister(MPU_REG_PWR_MGMT_1, MPU_PWR_CLOCK_GYRO_X);
+  writeRegister(MPU_REG_PWR_MGMT_2, 0);
+  writeRegister(MPU_REG_GYRO_CONFIG, MPU_GYRO_2000_DPS);
+  writeRegister(MPU_REG_ACCEL_CONFIG, MPU_ACCEL_16_G);
+  writeRegister(MPU_REG_INT_ENABLE, 0);
+  
+  gyroBiasQ8 = gyroBias;
+  updateThreshold();
+  fifoMode = MPU_FIFO_SAMPLING && beginFifo();
+  if (!fifoMode) {
+    writeRegister(MPU_REG_CONFIG, MPU_DLPF_21_HZ);  // As begin() sets it for polling
+  }
+  mpuInitialized = true;
+  return true;
+}
+
+/**
+ * Leave only motion detection running, at a few microamps, before the
+ * board goes into deep sleep. Returns false without an MPU to wake it.
+ */
+bool AccelerometerHandler::armMotionWake() {
+  if (!mpuInitialized) {
+    return false;
+  }
   
+  if (fifoMode) {
+    detachInterrupt(digitalPinToInterrupt(MPU_INT_PIN));
+    writeRegister(MPU_REG_FIFO_EN, 0);
+    writeRegister(MPU_REG_USER_CTRL, 0);
+  }
+  writeRegister(MPU_REG_CONFIG, 0);
+  writeRegister(MPU_REG_ACCEL_CONFIG, MPU_ACCEL_16_G | MPU_ACCEL_HPF_5_HZ);
+  writeRegister(MPU_REG_MOT_THR, MPU_MOTION_THRESHOLD);
+  writeRegister(MPU_REG_MOT_DUR, MPU_MOTION_DURATION);
+  writeRegister(MPU_REG_INT_PIN_CFG, MPU_INT_LATCH);
+  writeRegister(MPU_REG_INT_ENABLE, MPU_INT_MOTION);
+  
+  // Clear anything latched while the staff was put down
+  uint8_t status;
+  readRegisters(MPU_REG_INT_STATUS, &status, 1);
+  
+  writeRegister(MPU_REG_PWR_MGMT_2, MPU_LP_WAKE_20_HZ | MPU_PWR_GYRO_STANDBY);
+  writeRegister(MPU_REG_PWR_MGMT_1, MPU_PWR_CYCLE | MPU_PWR_TEMP_OFF);
   return true;
 }
 
+/**
+ * Check the motion latch on a sleep check wake (reading it clears it)
+ * An MPU that doesn't answer counts as motion, so the staff wakes up
+ * rather than sleeping for good.
+ */
+bool AccelerometerHandler::motionLatched() {
+  Wire.begin(SDA_PIN, SCL_PIN);
+  Wire.setClock(MPU_I2C_CLOCK);
+  
+  uint8_t status;
+  if (!readRegisters(MPU_REG_INT_STATUS, &status, 1)) {
+    return true;
+  }
+  return (status & MPU_INT_MOTION) != 0;
+}
+
 void AccelerometerHandler::update() {
   if (!mpuInitialized) {
-    Serial.println("Accelerometer not initialized, attempt to restart");
-    begin(config); // Try to reinitialize
+    // Try to reinitialize, but not on every call - a missing chip would
+    // otherwise stall every loop() with an I2C timeout and a log line
+    if (millis() - lastRetryTime >= MPU_RETRY_INTERVAL_MS) {
+      lastRetryTime = millis();
+      LOG_WARN("Accelerometer not initialized, attempt to restart");
+      begin(config);
+    }
     return;
   }
   
-  // Get new sensor events
-  sensors_event_t a, g, temp;
-  if (!mpu.getEvent(&a, &g, &temp)) {
-    Serial.println("Failed to read from MPU6050");
-    return;
+  // Calibration or loaded settings may have changed it
+  if (config->impactThreshold != thresholdSqFor) {
+    updateThreshold();
   }
   
-  // Calculate magnitude of acceleration
-  float accelMagnitude = sqrt(a.acceleration.x * a.acceleration.x + 
-                             a.acceleration.y * a.acceleration.y + 
-                             a.acceleration.z * a.acceleration.z);
-  
-  // Convert to raw value comparable with threshold
-  uint16_t accelRaw = (uint16_t)(accelMagnitude * 100);
-  
-  // Use the configured threshold instead of hard-coded value
-  uint16_t currentThreshold = config->impactThreshold;
-  
-  // CHANGED: Comment out or reduce frequency of debug printing
-  // Only print every 5 seconds instead of every second to reduce potential I2C conflicts
-  /*
-  static unsigned long lastPrint = 0;
-  if (millis() - lastPrint > 5000) {
-    Serial.print("Accel: "); Serial.print(accelRaw);
-    Serial.print(" (X:"); Serial.print(a.acceleration.x);
-    Serial.print(" Y:"); Serial.print(a.acceleration.y);
-    Serial.print(" Z:"); Serial.print(a.acceleration.z);
-    Serial.print(") Threshold: "); Serial.println(currentThreshold);
-    lastPrint = millis();
-  }
-  */
-  
-  // Check for impact (with cooldown to prevent multiple triggers)
-  if (accelRaw > currentThreshold && 
-      (millis() - lastImpactTime > impactCooldown)) {
-    impactDetectedFlag = true;
-    lastImpactTime = millis();
-    
-    Serial.println("!!! IMPACT DETECTED !!!");
-    Serial.print("Magnitude: "); Serial.print(accelRaw);
-    Serial.print(" (Threshold: "); Serial.print(currentThreshold);
-    Serial.println(")");
+  unsigned long start = micros();
+  if (fifoMode) {
+    readFifo(true);
   } else {
-    // Only log when debug is enabled
-    #ifdef DEBUG_MODE
-    if (accelRaw <= currentThreshold) {
-      Serial.println("No impact: Acceleration below threshold");
+    updatePolled();
+  }
+  readMicros += micros() - start;
+}
+
+/**
+ * Read every sample queued in the FIFO and run impact detection over the batch
+ * Each sample is timestamped from the data-ready interrupt: the newest one
+ * was taken at the last interrupt, the others one sample period apart
+ * before it (accurate to about one period). Returns the batch peak as a
+ * squared magnitude in raw counts.
+ */
+uint32_t AccelerometerHandler::readFifo(bool detectImpacts) {
+  uint8_t countBytes[2];
+  if (!readRegisters(MPU_REG_FIFO_COUNT_H, countBytes, 2)) {
+    LOG_WARN("Failed to read from MPU6050");
+    return 0;
+  }
+  uint16_t count = (countBytes[0] << 8) | countBytes[1];
+  
+  // A full FIFO has dropped samples and is no longer aligned to whole
+  // samples (e.g. after a long blocking section), so start over
+  if (count >= MPU_FIFO_SIZE - sampleBytes || count % sampleBytes) {
+    fifoOverflows++;
+    resetFifo();
+    lastBatchSize = 0;
+    return 0;
+  }
+  
+  uint16_t samples = count / sampleBytes;
+  lastBatchSize = samples;
+  if (samples == 0) {
+    return 0;
+  }
+  
+  static uint32_t lastDataReadyCount = 0;
+  noInterrupts();
+  unsigned long newestMicros = dataReadyMicros;
+  uint32_t readyCount = dataReadyCount;
+  interrupts();
+  if (readyCount == lastDataReadyCount) {
+    // No interrupt since the last batch (INT not wired?), use the read time
+    newestMicros = micros();
+  }
+  lastDataReadyCount = readyCount;
+  
+  uint32_t peakSq = 0;
+  uint16_t index = 0;
+  int32_t gyroSum = 0;
+  bool spinSamples = (sampleBytes == MPU_SPIN_BYTES);
+  uint8_t buffer[MPU_BURST_BYTES];
+  while (index < samples) {
+    uint8_t burst = min<uint16_t>(samples - index, MPU_BURST_BYTES / sampleBytes);
+    if (!readRegisters(MPU_REG_FIFO_R_W, buffer, burst * sampleBytes)) {
+      // Whatever is left is picked up with the next batch
+      break;
     }
     
-    if (millis() - lastImpactTime <= impactCooldown) {
-      Serial.println("No impact: Within cooldown period");
+    const uint8_t* p = buffer;
+    for (uint8_t s = 0; s < burst; s++, index++, p += sampleBytes) {
+      if (spinSamples) {
+        gyroSum += (int16_t)((p[6] << 8) | p[7]);
+      }
+      
+      uint32_t magSq = squaredMagnitude(p);
+      if (magSq > peakSq) {
+        peakSq = magSq;
+      }
+      
+      if (detectImpacts && magSq > thresholdSq) {
+        unsigned long sampleMicros = newestMicros - (unsigned long)(samples - 1 - index) * samplePeriodUs;
+        checkImpact(magSq, sampleMicros);
+      }
     }
-    #endif
-    
-    impactDetectedFlag = false;
   }
+  
+  if (spinSamples && index > 0) {
+    updateSpin(gyroSum, index, newestMicros - (unsigned long)(samples - index) * samplePeriodUs);
+  }
+  
+  sampleCount += index;
+  return peakSq;
+}
+
+/**
+ * Read a single sample straight from the accel registers (MPU_FIFO_SAMPLING off)
+ */
+void AccelerometerHandler::updatePolled() {
+  uint8_t data[MPU_ACCEL_BYTES];
+  if (!readRegisters(MPU_REG_ACCEL_XOUT_H, data, MPU_ACCEL_BYTES)) {
+    LOG_WARN("Failed to read from MPU6050");
+    return;
+  }
+  
+  lastBatchSize = 1;
+  sampleCount++;
+  uint32_t magSq = squaredMagnitude(data);
+  if (magSq > thresholdSq) {
+    checkImpact(magSq, micros());
+  }
+}
+
+/**
+ * Flag an impact for a sample over the threshold unless still in the cooldown
+ */
+void AccelerometerHandler::checkImpact(uint32_t magSq, unsigned long sampleMicros) {
+  if (sampleMicros - lastImpactMicros <= impactCooldown * 1000UL) {
+    return;
+  }
+  
+  impactDetectedFlag = true;
+  lastImpactMicros = sampleMicros;
+  detectMicros = micros();
+  lastImpactMagSq = magSq;
+  lastImpactTime = millis();
+}
+
+/**
+ * Log the last impact - called once the flash is out, so the serial
+ * output doesn't add to the impact latency
+ */
+void AccelerometerHandler::printImpact() {
+  LOG_INFO("!!! IMPACT DETECTED !!! Magnitude: %u (Threshold: %u)",
+           magnitudeUnits(lastImpactMagSq), config->impactThreshold);
+}
+
+/**
+ * Pre-square the threshold in raw counts so samples are compared without a
+ * square root or floats
+ */
+void AccelerometerHandler::updateThreshold() {
+  thresholdSqFor = config->impactThreshold;
+  uint32_t counts = ((uint32_t)thresholdSqFor * COUNTS_PER_UNIT_Q14) >> 14;
+  uint64_t squared = (uint64_t)counts * counts;
+  thresholdSq = squared > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)squared;
+}
+
+// Magnitude in threshold units, for calibration and logging only
+uint16_t AccelerometerHandler::magnitudeUnits(uint32_t magSq) {
+  return (uint16_t)min(sqrtf(magSq) * ACCEL_UNITS_PER_COUNT, 65535.0f);
+}
+
+/**
+ * Print the sensor read cost since the last call and start over
+ */
+void AccelerometerHandler::printStats() {
+  // Read cost to a tenth of a microsecond, without float formatting
+  LOG_INFO("Accel: %lu samples, %lu.%lu us/sample, FIFO overflows: %lu",
+           (unsigned long)sampleCount,
+           sampleCount > 0 ? (unsigned long)(readMicros / sampleCount) : 0UL,
+           sampleCount > 0 ? (unsigned long)((uint64_t)readMicros * 10 / sampleCount % 10) : 0UL,
+           (unsigned long)fifoOverflows);
+  
+  sampleCount = 0;
+  readMicros = 0;
+  fifoOverflows = 0;
 }
 
 bool AccelerometerHandler::impactDetected() {
@@ -120,6 +548,11 @@ bool AccelerometerHandler::impactDetected() {
 }
 
 void AccelerometerHandler::calibrate() {
+  // Baseline readings go through the driver, which start() skips
+  if (mpuInitialized && !driverStarted) {
+    begin(config);
+  }
+  
   if (!mpuInitialized) {
     Serial.println("ERROR: Cannot calibrate - Accelerometer not initialized");
     return;
@@ -193,7 +626,21 @@ void AccelerometerHandler::calibrate() {
     unsigned long impactStart = millis();
     uint16_t maxImpact = 0;
     
-    while (millis() - impactStart < 3000) {
+    if (fifoMode) {
+      // Use every FIFO sample, so the peak matches what detection sees
+      resetFifo();
+      while (millis() - impactStart < 3000) {
+        uint16_t peak = magnitudeUnits(readFifo(false));
+        if (peak > maxImpact) {
+          maxImpact = peak;
+          Serial.print("Current: "); Serial.print(peak);
+          Serial.print(", Max: "); Serial.println(maxImpact);
+        }
+        delay(20);
+      }
+    }
+    
+    while (!fifoMode && millis() - impactStart < 3000) {
       sensors_event_t a, g, temp;
       if (mpu.getEvent(&a, &g, &temp)) {
         float accelMagnitude = sqrt(a.acceleration.x * a.acceleration.x + 
@@ -260,6 +707,11 @@ void AccelerometerHandler::calibrate() {
   Serial.print("New impact threshold set to: ");
   Serial.println(config->impactThreshold);
   Serial.println("Calibration complete!");
+  
+  if (fifoMode) {
+    // The FIFO overflowed while waiting for button presses
+    resetFifo();
+  }
   Serial.println("NOTE: Remember to save settings for the new threshold to persist.");
 }
 
@@ -0,0 +1,146 @@
+#include "BoStaff.h"
+#include "Ws2812Encoder.h"
+
+#if LED_OUTPUT_ASYNC
+
+// Only strip 2 can be driven this way: D4 (GPIO2) doubles as the UART1 TX
+// pin. D3 (GPIO0) has no UART or I2S function, so strip 1 stays on FastLED.
+//
+// UART1 has no DMA and its FIFO holds 128 bytes (320 us of LED data), so
+// timer1 fires every REFILL_US to top the FIFO up. Serial (UART0) and its
+// interrupt handler are left alone.
+
+#define UART_FIFO_SIZE 128
+#define FRAME_BYTES (NUM_LEDS_PER_STRIP * WS2812_UART_BYTES_PER_PIXEL)
+
+// timer1 runs at 80 MHz / 16 = 5 ticks per microsecond
+#define TIMER_TICKS_PER_US 5
+#define REFILL_US 200   // FIFO drains 80 bytes, leaving ~120 us of slack
+#define LATCH_US 650    // Drain the last FIFO (320 us) plus the >280 us WS2812B reset
+
+// Two frames: one on the wire, one being rendered or queued behind it
+static uint8_t frameBuffers[2][FRAME_BYTES];
+static uint16_t frameLengths[2];  // Bytes used, POV columns only send the first row
+
+static volatile const uint8_t* txPos = nullptr;
+static volatile const uint8_t* txEnd = nullptr;
+static volatile int8_t txBuffer = -1;       // Buffer being clocked out, -1 if idle
+static volatile int8_t pendingBuffer = -1;  // Buffer queued behind it
+static volatile bool latching = false;
+
+static void IRAM_ATTR fillFifo() {
+  const uint8_t* pos = (const uint8_t*)txPos;
+  const uint8_t* end = (const uint8_t*)txEnd;
+  int room = UART_FIFO_SIZE - 1 - (int)((USS(UART1) >> USTXC) & 0xFF);
+
+  while (room-- > 0 && pos < end) {
+    USF(UART1) = *pos++;
+  }
+  txPos = pos;
+}
+
+static void IRAM_ATTR startBuffer(int8_t buffer) {
+  txBuffer = buffer;
+  txPos = frameBuffers[buffer];
+  txEnd = frameBuffers[buffer] + frameLengths[buffer];
+  fillFifo();
+  timer1_write(REFILL_US * TIMER_TICKS_PER_US);
+}
+
+static void IRAM_ATTR onOutputTimer() {
+  if (latching) {
+    // Previous frame is latched, start the queued one if any
+    latching = false;
+    txBuffer = -1;
+    if (pendingBuffer >= 0) {
+      int8_t next = pendingBuffer;
+      pendingBuffer = -1;
+      startBuffer(next);
+    }
+    return;
+  }
+
+  fillFifo();
+  if (txPos < txEnd) {
+    timer1_write(REFILL_US * TIMER_TICKS_PER_US);
+  } else {
+    latching = true;
+    timer1_write(LATCH_US * TIMER_TICKS_PER_US);
+  }
+}
+
+/**
+ * Configure UART1 as a WS2812 bit generator and hook up the refill timer
+ */
+bool AsyncLedOutput::begin() {
+  Serial1.begin(WS2812_UART_BAUD, SERIAL_6N1, SERIAL_TX_ONLY);
+
+  // Invert TX so the idle line is low, which is the WS2812 reset level
+  USC0(UART1) |= (1 << UCTXI);
+
+  timer1_isr_init();
+  timer1_attachInterrupt(onOutputTimer);
+  timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+
+  Serial.println(F("Async LED output on UART1 (D4) initialized"));
+  return true;
+}
+
+/**
+ * Encode the first count pixels and queue them behind the frame on the wire
+ * A frame still waiting in the queue is replaced - the newest frame wins.
+ * With preempt the frame on the wire is cut short instead: the FIFO drains
+ * and latches what was sent so far, and the new frame starts within ~1 ms
+ * rather than up to 6 ms.
+ */
+void AsyncLedOutput::show(const CRGB* pixels, uint16_t count, const CRGB& scale, bool preempt) {
+  if (count > NUM_LEDS_PER_STRIP) {
+    count = NUM_LEDS_PER_STRIP;
+  }
+  
+  noInterrupts();
+  pendingBuffer = -1;
+  if (preempt && txBuffer >= 0 && !latching) {
+    txEnd = txPos;
+  }
+  int8_t buffer = (txBuffer == 0) ? 1 : 0;
+  interrupts();
+
+  // Neither the timer nor the queue can touch this buffer while we encode
+  ws2812EncodeUart(pixels, count, scale, frameBuffers[buffer]);
+  frameLengths[buffer] = count * WS2812_UART_BYTES_PER_PIXEL;
+
+  noInterrupts();
+  if (txBuffer < 0) {
+    startBuffer(buffer);
+  } else {
+    pendingBuffer = buffer;
+  }
+  interrupts();
+}
+
+bool AsyncLedOutput::busy() const {
+  return txBuffer >= 0 || pendingBuffer >= 0;
+}
+
+/**
+ * Wait until the last frame is latched and the refill timer has stopped
+ * With preempt the frame on the wire is cut short (as in show()), so this
+ * takes at most ~1 ms instead of up to 6.6 ms
+ */
+void AsyncLedOutput::waitIdle(bool preempt) {
+  noInterrupts();
+  if (preempt) {
+    pendingBuffer = -1;
+    if (txBuffer >= 0 && !latching) {
+      txEnd = txPos;
+    }
+  }
+  interrupts();
+  
+  while (busy()) {
+    yield();
+  }
+}
+
+#endif // LED_OUTPUT_ASYNC
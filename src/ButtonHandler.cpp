@@ -44,7 +44,7 @@ void ButtonHandler::handle() {
       // Button press detected (on press, not release)
       if (buttonState) {
         modeChange = true;
-        Serial.println(F("Button pressed - mode change requested"));
+        LOG_DEBUG("Button pressed - mode change requested");
       }
     }
   }
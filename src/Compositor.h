@@ -0,0 +1,137 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <FastLED.h>
+#include "PowerLimiter.h"
+
+// Overlays that can be shown at once; adding one more replaces the oldest
+#define COMPOSITOR_OVERLAYS 2
+
+// How an overlay combines with the pixels under it
+enum BlendMode : uint8_t {
+  BLEND_ADD,     // Saturating sum, brightens everything
+  BLEND_SCREEN,  // Brightens like add but never clips, dark pixels gain most
+  BLEND_MAX      // Per channel maximum, only lifts what's darker than the overlay
+};
+
+inline uint8_t blendChannel(uint8_t base, uint8_t over, BlendMode mode) {
+  switch (mode) {
+    case BLEND_ADD:    return qadd8(base, over);
+    case BLEND_SCREEN: return base + scale8(over, 255 - base);
+    default:           return base > over ? base : over;
+  }
+}
+
+// Overlay alpha over time (ms): ramps up over attack, holds at full and
+// fades out over release
+struct AlphaEnvelope {
+  uint16_t attack;
+  uint16_t hold;
+  uint16_t release;
+
+  unsigned long length() const {
+    return (unsigned long)attack + hold + release;
+  }
+
+  uint8_t at(unsigned long elapsed) const {
+    if (elapsed < attack) {
+      return elapsed * 255 / attack;
+    }
+    elapsed -= attack;
+    if (elapsed < hold) {
+      return 255;
+    }
+    elapsed -= hold;
+    if (elapsed < release) {
+      return 255 - elapsed * 255 / release;
+    }
+    return 0;
+  }
+};
+
+// Lays short-lived flat-color overlays (e.g. the impact flash) over a base
+// frame. The base effect keeps rendering into its own buffer underneath, so
+// nothing is lost when an overlay ends. begin() works out each overlay's
+// color at its current alpha once per frame; apply() then composites all
+// of them in one pass over the pixels.
+// Pure logic on caller-supplied buffers, so it also runs on the host.
+class Compositor {
+private:
+  struct Overlay {
+    CRGB color;
+    BlendMode mode;
+    AlphaEnvelope envelope;
+    unsigned long start;
+    bool active;
+  };
+
+  Overlay overlays[COMPOSITOR_OVERLAYS];
+  CRGB frameColor[COMPOSITOR_OVERLAYS];  // Colors at this frame's alpha
+  BlendMode frameMode[COMPOSITOR_OVERLAYS];
+  uint8_t frameCount;
+
+public:
+  Compositor() : frameCount(0) { clear(); }
+
+  void add(const CRGB& color, BlendMode mode, const AlphaEnvelope& envelope, unsigned long now) {
+    uint8_t slot = 0;
+    for (uint8_t i = 0; i < COMPOSITOR_OVERLAYS; i++) {
+      if (!overlays[i].active) {
+        slot = i;
+        break;
+      }
+      // Ages rather than start times, so millis() wrapping can't reorder them
+      if (now - overlays[i].start > now - overlays[slot].start) {
+        slot = i;
+      }
+    }
+    overlays[slot] = { color, mode, envelope, now, true };
+  }
+
+  void clear() {
+    for (uint8_t i = 0; i < COMPOSITOR_OVERLAYS; i++) {
+      overlays[i].active = false;
+    }
+    frameCount = 0;
+  }
+
+  // Prepare the overlays for the frame at now, dropping finished ones
+  // Returns false if none is showing, apply() would leave the base as is
+  bool begin(unsigned long now) {
+    frameCount = 0;
+    for (uint8_t i = 0; i < COMPOSITOR_OVERLAYS; i++) {
+      Overlay& overlay = overlays[i];
+      if (!overlay.active) {
+        continue;
+      }
+      unsigned long elapsed = now - overlay.start;
+      if (elapsed >= overlay.envelope.length()) {
+        overlay.active = false;
+        continue;
+      }
+      CRGB color = overlay.color;
+      color.nscale8_video(overlay.envelope.at(elapsed));
+      frameColor[frameCount] = color;
+      frameMode[frameCount] = overlay.mode;
+      frameCount++;
+    }
+    return frameCount > 0;
+  }
+
+  // out = base with this frame's overlays on top (base may be out),
+  // summed into the power estimate
+  void apply(const CRGB* base, CRGB* out, uint16_t count, PowerEstimate& power) const {
+    for (uint16_t i = 0; i < count; i++) {
+      CRGB pixel = base[i];
+      for (uint8_t o = 0; o < frameCount; o++) {
+        pixel.r = blendChannel(pixel.r, frameColor[o].r, frameMode[o]);
+        pixel.g = blendChannel(pixel.g, frameColor[o].g, frameMode[o]);
+        pixel.b = blendChannel(pixel.b, frameColor[o].b, frameMode[o]);
+      }
+      out[i] = pixel;
+      power.add(pixel);
+    }
+  }
+};
+
+#endif // COMPOSITOR_H
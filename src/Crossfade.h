@@ -0,0 +1,57 @@
+#ifndef CROSSFADE_H
+#define CROSSFADE_H
+
+#include <FastLED.h>
+#include "PowerLimiter.h"
+
+// Crossfade weight of the incoming frame: 0 shows only the outgoing one,
+// CROSSFADE_FULL only the incoming one
+#define CROSSFADE_FULL 256
+
+// Reference blend of one channel, out = (from * (256 - amount) + to * amount) / 256
+inline uint8_t crossfadeByte(uint8_t from, uint8_t to, uint16_t amount) {
+  return (uint8_t)(((uint16_t)from * (CROSSFADE_FULL - amount) + (uint16_t)to * amount) >> 8);
+}
+
+// Blend count pixels of two frames into out
+// Works on four channel bytes per 32-bit word: the even and odd bytes are
+// split into two words of 16-bit lanes, so one multiply weights two bytes.
+// A lane sums to at most 255 x 256, so it can't carry into the next one,
+// and the result is exactly crossfadeByte() for every channel. The word
+// loop needs all three buffers 4-byte aligned, otherwise it's done bytewise.
+// The blended pixels are summed into the power estimate as they're written.
+// Pure function, so it can be checked and benchmarked on the host.
+inline void crossfadePixels(const CRGB* from, const CRGB* to, CRGB* out, uint16_t count, uint16_t amount,
+                            PowerEstimate& power) {
+  const uint8_t* a = from->raw;
+  const uint8_t* b = to->raw;
+  uint8_t* o = out->raw;
+  size_t bytes = (size_t)count * 3;
+  size_t i = 0;
+
+  if ((((uintptr_t)a | (uintptr_t)b | (uintptr_t)o) & 3) == 0) {
+    const uint32_t* wa = reinterpret_cast<const uint32_t*>(a);
+    const uint32_t* wb = reinterpret_cast<const uint32_t*>(b);
+    uint32_t* wo = reinterpret_cast<uint32_t*>(o);
+    uint32_t inverse = CROSSFADE_FULL - amount;
+    WordChannelSums sums(power);
+    size_t words = bytes / 4;
+    for (size_t w = 0; w < words; w++) {
+      uint32_t x = wa[w];
+      uint32_t y = wb[w];
+      uint32_t even = ((x & 0x00FF00FF) * inverse + (y & 0x00FF00FF) * amount) >> 8;
+      uint32_t odd = ((x >> 8) & 0x00FF00FF) * inverse + ((y >> 8) & 0x00FF00FF) * amount;
+      uint32_t blended = (even & 0x00FF00FF) | (odd & 0xFF00FF00);
+      wo[w] = blended;
+      sums.add(blended);
+    }
+    i = words * 4;
+  }
+
+  for (; i < bytes; i++) {
+    o[i] = crossfadeByte(a[i], b[i], amount);
+    power.channel[i % 3] += o[i];
+  }
+}
+
+#endif // CROSSFADE_H
@@ -0,0 +1,175 @@
+#include "BoStaff.h"
+#include <new>
+#include <utility>
+
+static_assert(STAFF_STRIP_LEDS == NUM_LEDS_PER_STRIP, "Staff geometry must describe the configured strips");
+
+// Builds the instance of an effect for one strip (0 or 1) in an arena slot
+typedef Effect* (*EffectFactory)(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t strip);
+
+// Placement-construct an effect in a slot, checking at compile time that it fits
+template <typename T, typename... Args>
+static Effect* construct(void* slot, Args&&... args) {
+  static_assert(sizeof(T) <= EFFECT_SLOT_SIZE, "Effect is larger than an arena slot - add it to EFFECT_SLOT_SIZE in effects.h");
+  static_assert(alignof(T) <= EFFECT_SLOT_ALIGN, "Effect needs more alignment than an arena slot - add it to EFFECT_SLOT_ALIGN in effects.h");
+  return new (slot) T(std::forward<Args>(args)...);
+}
+
+struct EffectDescriptor {
+  uint8_t type;
+  EffectFactory create;
+  CRGB::HTMLColorCode fallbackColor;  // Shown if the effect can't be constructed
+  bool symmetric;  // Same content on both strips and mirrored across the fold
+};
+
+static Effect* createSolid(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t /*strip*/) {
+  return construct<SolidEffect>(slot, leds, geometry);
+}
+
+static Effect* createFire(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t strip) {
+  // Second strip runs reversed
+  return construct<FireEffect>(slot, leds, geometry, strip == 1);
+}
+
+static Effect* createPulse(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t /*strip*/) {
+  return construct<PulseEffect>(slot, leds, geometry);
+}
+
+static Effect* createRainbow(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t /*strip*/) {
+  return construct<RainbowEffect>(slot, leds, geometry);
+}
+
+static Effect* createStrobe(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t /*strip*/) {
+  return construct<StrobeEffect>(slot, leds, geometry);
+}
+
+static Effect* createPov(void* slot, CRGB* leds, const StaffGeometry& geometry, uint8_t strip) {
+  // The second strip points the other way from the hilt, half a turn on
+  return construct<PovEffect>(
+    slot, leds, geometry, POV_IMAGE, strip == 1 ? 0x80000000UL : 0);
+}
+
+// Adding an effect only needs an entry here (and in EffectType / EFFECT_NAMES)
+// Fire seeds each strip independently, so it renders every pixel itself,
+// and the POV strips show different columns
+static const EffectDescriptor EFFECT_TABLE[] = {
+  { EFFECT_SOLID,   createSolid,   CRGB::Black, true },
+  { EFFECT_FIRE,    createFire,    CRGB::Red,   false },
+  { EFFECT_PULSE,   createPulse,   CRGB::Blue,  true },
+  { EFFECT_RAINBOW, createRainbow, CRGB::Green, true },
+  { EFFECT_STROBE,  createStrobe,  CRGB::White, true },
+  { EFFECT_POV,     createPov,     CRGB::Purple, false },
+};
+
+static const EffectDescriptor* findEffect(uint8_t type) {
+  for (size_t i = 0; i < sizeof(EFFECT_TABLE) / sizeof(EFFECT_TABLE[0]); i++) {
+    if (EFFECT_TABLE[i].type == type) {
+      return &EFFECT_TABLE[i];
+    }
+  }
+  return nullptr;
+}
+
+void EffectRegistry::begin(CRGB* strip1, CRGB* strip2, CRGB* lineBuffer) {
+  strips[0] = strip1;
+  strips[1] = strip2;
+  line = lineBuffer;
+}
+
+/**
+ * Tear down the current effect and construct the requested one
+ * Returns false if the effect is unknown or failed to initialize
+ */
+bool EffectRegistry::activate(uint8_t type) {
+  release();
+
+  active = findEffect(type);
+  if (!active) {
+    LOG_ERROR("Unknown effect type: %u", type);
+    return false;
+  }
+
+  bool ok = true;
+  if (active->symmetric) {
+    // One instance draws the hilt-to-tip line for all four half-strips
+    instances[0] = active->create(arena[0], line, staffGeometry<LAYOUT_LINE>(), 0);
+    ok = instances[0] && instances[0]->isInitialized();
+  } else {
+    for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+      // Both strips use the folded arrangement (see docs/led-arrangement.md)
+      instances[s] = active->create(arena[s], strips[s], staffGeometry<LAYOUT_FOLDED>(), s);
+      if (!instances[s] || !instances[s]->isInitialized()) {
+        ok = false;
+      }
+    }
+  }
+
+  if (!ok) {
+    LOG_ERROR("Error initializing effect: %s", EFFECT_NAMES[type]);
+    release();
+    active = findEffect(type);
+    fallbackActive = true;
+    return false;
+  }
+
+  setDetail(detail);
+  return true;
+}
+
+/**
+ * Destroy the active effect instances, leaving their arena slots free
+ */
+void EffectRegistry::release() {
+  for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+    if (instances[s]) {
+      instances[s]->~Effect();
+      instances[s] = nullptr;
+    }
+  }
+  active = nullptr;
+  fallbackActive = false;
+}
+
+/**
+ * Render the next frame of the active effect
+ * Returns true if any instance changed its buffer
+ */
+bool EffectRegistry::update(const FrameTime& time) {
+  if (!active) {
+    return false;
+  }
+
+  if (fallbackActive) {
+    // Fallback to a simple effect if the real one is not available
+    // (error path, so it's simply redrawn and sent every frame)
+    for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+      fill_solid(strips[s], NUM_LEDS_PER_STRIP, active->fallbackColor);
+    }
+    return true;
+  }
+
+  bool changed = false;
+  for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+    if (instances[s] && instances[s]->update(time)) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+bool EffectRegistry::rendersLine() const {
+  return active && active->symmetric && !fallbackActive;
+}
+
+uint8_t EffectRegistry::activeType() const {
+  return active ? active->type : (uint8_t)NUM_EFFECTS;
+}
+
+void EffectRegistry::setDetail(uint8_t level) {
+  detail = level;
+  for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+    if (instances[s]) {
+      instances[s]->setDetail(level);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef EFFECT_H
+#define EFFECT_H
+
+#include <FastLED.h>
+#include "../Logger.h"
+
+// Timing of one frame, handed to every effect by the frame clock
+// Effects animate from these instead of calling millis() themselves, so
+// their speed doesn't depend on the frame rate
+struct FrameTime {
+  unsigned long now;  // millis() at the start of the frame
+  unsigned long dt;   // Milliseconds since the previous frame
+};
+
+// beat8() at a given time instead of millis()
+inline uint8_t beat8At(unsigned long now, uint8_t bpm) {
+  return (uint16_t)(((uint32_t)now * ((uint32_t)bpm << 8) * 280) >> 16) >> 8;
+}
+
+// Turns frame deltas into a fixed number of animation steps, for effects
+// that advance by simulation steps rather than as a function of time
+class StepTimer {
+private:
+  unsigned long interval;
+  unsigned long elapsed;
+
+public:
+  explicit StepTimer(unsigned long intervalMs) : interval(intervalMs), elapsed(0) {}
+
+  // Steps due this frame; after a long stall the backlog is dropped
+  // rather than replayed all at once
+  uint8_t advance(unsigned long dt, uint8_t maxSteps = 4) {
+    elapsed += dt;
+    uint8_t steps = 0;
+    while (elapsed >= interval && steps < maxSteps) {
+      elapsed -= interval;
+      steps++;
+    }
+    if (elapsed >= interval) {
+      elapsed %= interval;
+    }
+    return steps;
+  }
+};
+
+// Common interface for all LED effects
+// Each instance renders into one LED array; the EffectRegistry creates the
+// instances for the active mode only and destroys them on mode change
+class Effect {
+public:
+  virtual ~Effect() {}
+
+  // False if construction failed (e.g. allocation), the registry then
+  // falls back to a solid color for this mode
+  virtual bool isInitialized() const = 0;
+
+  // Render the frame at time.now into the LED array
+  // Returns false if the array was left untouched (e.g. between animation
+  // steps), so the frame doesn't need to be sent to the strips again
+  virtual bool update(const FrameTime& time) = 0;
+
+  // How much work the effect may spend per frame, 255 = full detail
+  // Set by the quality governor; effects without a cheaper variant ignore it
+  virtual void setDetail(uint8_t /*detail*/) {}
+
+  // Animation state kept in RTC memory across deep sleep, so the effect
+  // carries on where it stopped instead of starting cold. saveState()
+  // returns the bytes written (0 if there's nothing worth keeping or it
+  // doesn't fit in room); restoreState() gets them back on resume.
+  virtual uint16_t saveState(uint8_t* /*state*/, uint16_t /*room*/) const { return 0; }
+  virtual void restoreState(const uint8_t* /*state*/, uint16_t /*length*/) {}
+};
+
+#endif // EFFECT_H
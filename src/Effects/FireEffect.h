@@ -2,62 +2,52 @@
 #define FIRE_EFFECT_H
 
 #include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
+#include "Palette.h"
+#include "HeatKernel.h"
+
+// Milliseconds per heat simulation step (the look was tuned at 20 steps/s)
+#define FIRE_STEP_MS 50
 
 // Advanced Fire Effect with more realistic appearance
 // Adapted for folded LED strip arrangement where LEDs at index 0 and (count-1) are at the center/hilt,
 // and LEDs at index (count/2-1) and (count/2) are at the far end
-class FireEffect {
+class FireEffect : public Effect {
 private:
   CRGB* ledArray;
+  const StaffGeometry* geometry;
   int numLeds;
-  byte* heat;
+  alignas(4) byte heat[STAFF_STRIP_LEDS];  // Sized for the longest layout, numLeds used; aligned for coolHeat()
   uint8_t cooling;
   uint8_t sparking;
   bool reversed;
-  bool isFolded; // Whether the LED strip is folded
   bool initialized; // New flag to track initialization status
-  unsigned long lastUpdate; // Timestamp of last update
+  StepTimer stepTimer;  // Heat simulation steps
+  const PaletteLut* customPalette;  // Heat value to color, nullptr = the shared heat table
   
 public:
-  FireEffect(CRGB* leds, int count, bool reverse = false, bool folded = true) : 
-    ledArray(nullptr), numLeds(0), heat(nullptr), cooling(85), sparking(90),
-    reversed(reverse), isFolded(folded), initialized(false), lastUpdate(0) {
+  FireEffect(CRGB* leds, const StaffGeometry& geo, bool reverse = false) : 
+    ledArray(nullptr), geometry(&geo), numLeds(0), cooling(85), sparking(90),
+    reversed(reverse), initialized(false), stepTimer(FIRE_STEP_MS), customPalette(nullptr) {
+    
+    int count = geo.numLeds;
     
     // Validate inputs
-    if (!leds || count <= 0) {
+    if (!leds || count <= 0 || count > STAFF_STRIP_LEDS) {
       // Handle invalid input
-      Serial.println("ERROR: FireEffect created with invalid parameters");
+      LOG_ERROR("FireEffect created with invalid parameters");
       return;
     }
     
     ledArray = leds;
     numLeds = count;
-    
-    // Allocate the heat array
-    heat = new byte[numLeds];
-    if (heat) {
-      // Initialize all elements to zero
-      memset(heat, 0, numLeds);
-      initialized = true; // Mark as successfully initialized
-    } else {
-      Serial.println("ERROR: FireEffect failed to allocate heat array");
-      numLeds = 0; // Mark as invalid
-    }
-    
-    lastUpdate = millis(); // Initialize the last update time
+    memset(heat, 0, sizeof(heat));
+    initialized = true; // Mark as successfully initialized
   }
   
-  ~FireEffect() {
-    if (heat) {
-      delete[] heat;
-      heat = nullptr;  // Prevent double deletion
-    }
-    initialized = false;
-    ledArray = nullptr; // Don't delete ledArray as it's managed elsewhere
-  }
-  
-  bool isInitialized() const {
-    return initialized && heat != nullptr && ledArray != nullptr;
+  bool isInitialized() const override {
+    return initialized && ledArray != nullptr;
   }
   
   void setCooling(uint8_t cool) {
@@ -67,53 +57,94 @@ public:
   void setSparking(uint8_t spark) {
     sparking = spark;
   }
+
+  // Color the heat with another scheme (e.g. a PaletteLut built from a
+  // GradientPalette), owned by the caller; nullptr goes back to the heat ramp
+  void setPalette(const PaletteLut* palette) {
+    customPalette = palette;
+  }
   
-  void update() {
+  // The heat map, so the fire is still burning on resume
+  uint16_t saveState(uint8_t* state, uint16_t room) const override {
+    if (!initialized || room < (uint16_t)numLeds) {
+      return 0;
+    }
+    memcpy(state, heat, numLeds);
+    return (uint16_t)numLeds;
+  }
+  
+  void restoreState(const uint8_t* state, uint16_t length) override {
+    if (initialized && length == (uint16_t)numLeds) {
+      memcpy(heat, state, numLeds);
+    }
+  }
+  
+  bool update(const FrameTime& time) override {
     // Safety check - make sure we have valid memory and initialization
     if (!isInitialized() || numLeds <= 0) {
       // Log error only once to avoid console spam
       static bool errorLogged = false;
       if (!errorLogged) {
-        Serial.println("ERROR: FireEffect update called on uninitialized effect");
+        LOG_ERROR("FireEffect update called on uninitialized effect");
         errorLogged = true;
       }
-      return;
+      return false;
     }
     
-    // Add timing control to prevent too-rapid updates
-    unsigned long currentMillis = millis();
-    // Only update the effect every 20ms (50 updates per second)
-    if (currentMillis - lastUpdate < 20) {
-      return;
+    // The simulation runs at a fixed step rate, independent of the frame rate
+    uint8_t steps = stepTimer.advance(time.dt);
+    if (steps == 0) {
+      return false;
+    }
+    while (steps--) {
+      simulate();
+    }
+    
+    // Step 4: Map from heat cells to LED colors through the palette
+    if (customPalette) {
+      drawHeat(*customPalette);
+    } else {
+      drawHeat(FlashPalette(HEAT_PALETTE_TABLE));
     }
-    lastUpdate = currentMillis;
     
+    return true;
+  }
+  
+private:
+  template <typename Palette>
+  void drawHeat(const Palette& palette) {
+    if (reversed) {
+      for (int j = 0; j < numLeds; j++) {
+        ledArray[(numLeds - 1) - j] = palette[heat[j]];
+      }
+    } else {
+      for (int j = 0; j < numLeds; j++) {
+        ledArray[j] = palette[heat[j]];
+      }
+    }
+  }
+  
+  // One step of the heat simulation
+  void simulate() {
     // For a folded strip, we need to treat the 'middle' LED indexes as the physical far end
     // and the 0 and (count-1) as the physical center/hilt
-    uint8_t midPoint = numLeds / 2;
+    uint8_t midPoint = geometry->halfLength;
+    bool isFolded = geometry->folded;
     
     // Step 1: Cool down every cell a little
-    for (int i = 0; i < numLeds; i++) {
-      heat[i] = qsub8(heat[i], random8(0, ((cooling * 10) / numLeds) + 2));
-    }
+    coolHeat(heat, numLeds, (uint8_t)((cooling * 10) / numLeds + 2));
   
     // Step 2: Heat from each cell drifts 'up' and diffuses
     // For folded arrangement, heat rises from both ends toward the middle
     if (isFolded) {
       // First half - heat rises from center (0) toward far end (midPoint-1)
-      for (int k = midPoint - 1; k >= 2; k--) {
-        heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
-      }
+      riseHeat(heat, 2, midPoint - 1);
       
       // Second half - heat rises from center (numLeds-1) toward far end (midPoint)
-      for (int k = midPoint; k < numLeds - 2; k++) {
-        heat[k] = (heat[k + 1] + heat[k + 2] + heat[k + 2]) / 3;
-      }
+      fallHeat(heat, midPoint, numLeds - 3);
     } else {
       // Standard upward drift for non-folded arrangement
-      for (int k = numLeds - 1; k >= 2; k--) {
-        heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3;
-      }
+      riseHeat(heat, 2, numLeds - 1);
     }
     
     // Step 3: Randomly ignite new sparks at the bottom/center
@@ -141,23 +172,6 @@ public:
         }
       }
     }
-  
-    // Step 4: Map from heat cells to LED colors
-    for (int j = 0; j < numLeds; j++) {
-      CRGB color = HeatColor(heat[j]);
-      int pixelnumber;
-      
-      if (reversed) {
-        pixelnumber = (numLeds - 1) - j;
-      } else {
-        pixelnumber = j;
-      }
-      
-      // Bounds check
-      if (pixelnumber >= 0 && pixelnumber < numLeds) {
-        ledArray[pixelnumber] = color;
-      }
-    }
   }
 };
 
@@ -0,0 +1,94 @@
+#ifndef HEAT_KERNEL_H
+#define HEAT_KERNEL_H
+
+#include <FastLED.h>
+
+// Heat simulation steps for FireEffect, working on the heat cells a 32-bit
+// word at a time where they can. Each gives exactly the result of the
+// plain per-cell loop it replaces, random8() sequence included, so the
+// host bench checks them against it (verifyHeatKernel()).
+
+// Same step as random8(), on a seed held in a register
+inline uint8_t nextRandom8(uint16_t& seed) {
+  seed = (uint16_t)(seed * 2053 + 13849);
+  return (uint8_t)((uint8_t)(seed & 0xFF) + (uint8_t)(seed >> 8));
+}
+
+// Exact floor(n / 3) for n up to 765 (three heat cells), without the
+// software divide the ESP8266 would otherwise call
+inline uint8_t divide3(uint16_t n) {
+  return (uint8_t)(((uint32_t)n * 683) >> 11);
+}
+
+// Step 1: heat[i] = qsub8(heat[i], random8(0, limit)) for count cells
+// Four random bytes are drawn into a word, scaled by limit and taken off
+// four cells at once. Bytes sit in two words of 16-bit lanes (even and
+// odd): r * limit fits a lane, and a lane keeps its borrow bit 8 only if
+// the cell was at least the cooling, which then masks the result to 0.
+// The word loop needs heat 4-byte aligned, otherwise it runs bytewise.
+inline void coolHeat(uint8_t* heat, uint16_t count, uint8_t limit) {
+  uint16_t seed = random16_get_seed();
+  uint16_t i = 0;
+
+  if (((uintptr_t)heat & 3) == 0) {
+    uint32_t* cells = reinterpret_cast<uint32_t*>(heat);
+    uint16_t words = count / 4;
+    for (uint16_t w = 0; w < words; w++) {
+      uint32_t r = nextRandom8(seed);
+      r |= (uint32_t)nextRandom8(seed) << 8;
+      r |= (uint32_t)nextRandom8(seed) << 16;
+      r |= (uint32_t)nextRandom8(seed) << 24;
+
+      uint32_t coolEven = (((r & 0x00FF00FF) * limit) >> 8) & 0x00FF00FF;
+      uint32_t coolOdd = ((((r >> 8) & 0x00FF00FF) * limit) >> 8) & 0x00FF00FF;
+
+      uint32_t x = cells[w];
+      uint32_t even = ((x & 0x00FF00FF) | 0x01000100) - coolEven;
+      uint32_t odd = (((x >> 8) & 0x00FF00FF) | 0x01000100) - coolOdd;
+      even &= ((even >> 8) & 0x00010001) * 0xFF;
+      odd &= ((odd >> 8) & 0x00010001) * 0xFF;
+      cells[w] = even | (odd << 8);
+    }
+    i = words * 4;
+  }
+
+  for (; i < count; i++) {
+    uint8_t cool = (uint8_t)((nextRandom8(seed) * limit) >> 8);
+    heat[i] = qsub8(heat[i], cool);
+  }
+
+  random16_set_seed(seed);
+}
+
+// Step 2: heat drifts into every cell from the two below it, over
+// first..last, as the loop
+//   for (k = last; k >= first; k--) heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2]) / 3
+// does it. Going down, each cell reads cells that aren't written yet, so
+// they're carried along in registers: one load per cell, no divide.
+inline void riseHeat(uint8_t* heat, int first, int last) {
+  if (last < first) {
+    return;
+  }
+  uint8_t above = heat[last - 1];
+  for (int k = last; k >= first; k--) {
+    uint8_t below = heat[k - 2];
+    heat[k] = divide3(above + 2 * below);
+    above = below;
+  }
+}
+
+// The same drift from the two cells above, ascending over first..last
+//   for (k = first; k <= last; k++) heat[k] = (heat[k + 1] + heat[k + 2] + heat[k + 2]) / 3
+inline void fallHeat(uint8_t* heat, int first, int last) {
+  if (last < first) {
+    return;
+  }
+  uint8_t near = heat[first + 1];
+  for (int k = first; k <= last; k++) {
+    uint8_t far = heat[k + 2];
+    heat[k] = divide3(near + 2 * far);
+    near = far;
+  }
+}
+
+#endif // HEAT_KERNEL_H
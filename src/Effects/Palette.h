@@ -0,0 +1,161 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <FastLED.h>
+
+// Maximum change per color channel in one palette blend step
+#define PALETTE_BLEND_STEP 16
+
+// Milliseconds per palette blend step (a full swing takes 16 steps)
+#define PALETTE_BLEND_MS 20
+
+// Palette sources: turn a palette index into a color
+// The LUT calls them 256 times when it's built, never per pixel
+
+// FastLED's heat ramp (black - red - yellow - white)
+struct HeatPalette {
+  CRGB operator()(uint8_t index) const { return HeatColor(index); }
+};
+
+// The rainbow color wheel at a fixed saturation, index = hue
+struct HuePalette {
+  uint8_t saturation;
+  CRGB operator()(uint8_t index) const { return CHSV(index, saturation, 255); }
+};
+
+// Linear gradient between two colors, for custom color schemes
+struct GradientPalette {
+  CRGB from;
+  CRGB to;
+  CRGB operator()(uint8_t index) const { return blend(from, to, index); }
+};
+
+// A color at a brightness, exactly as CHSV's value channel darkens it, so
+// a full-brightness hue table can replace CHSV(hue, sat, val)
+inline CRGB dimColor(const CRGB& c, uint8_t brightness) {
+  if (brightness == 255) {
+    return c;
+  }
+  uint8_t v = scale8_video(brightness, brightness);
+  if (v == 0) {
+    return CRGB(0, 0, 0);
+  }
+  return CRGB(c.r ? scale8(c.r, v) + 1 : 0,
+              c.g ? scale8(c.g, v) + 1 : 0,
+              c.b ? scale8(c.b, v) + 1 : 0);
+}
+
+// 256-entry RGB lookup table in RAM, for palettes that change at runtime
+// Effects write palette indices instead of converting HSV or heat values
+// for every pixel; the table is rebuilt only when the palette changes.
+class PaletteLut {
+private:
+  CRGB entries[256];
+
+public:
+  template <typename Source>
+  void build(const Source& source) {
+    for (uint16_t i = 0; i < 256; i++) {
+      entries[i] = source(i);
+    }
+  }
+
+  const CRGB& operator[](uint8_t index) const {
+    return entries[index];
+  }
+
+  CRGB dimmed(uint8_t index, uint8_t brightness) const {
+    return dimColor(entries[index], brightness);
+  }
+
+  // Move every entry up to maxChange per channel towards the source,
+  // like nblendPaletteTowardPalette(); returns false once they all match
+  template <typename Source>
+  bool blendToward(const Source& source, uint8_t maxChange) {
+    bool changed = false;
+    for (uint16_t i = 0; i < 256; i++) {
+      CRGB target = source(i);
+      for (uint8_t ch = 0; ch < 3; ch++) {
+        uint8_t& cur = entries[i][ch];
+        uint8_t goal = target[ch];
+        if (cur < goal) {
+          cur = (goal - cur > maxChange) ? cur + maxChange : goal;
+          changed = true;
+        } else if (cur > goal) {
+          cur = (cur - goal > maxChange) ? cur - maxChange : goal;
+          changed = true;
+        }
+      }
+    }
+    return changed;
+  }
+};
+
+// Fixed palettes, built by the compiler into flash (src/Palettes.cpp) and
+// shared by every instance, so they take no RAM. Entries are 0x00RRGGBB
+// words: one aligned flash read per pixel.
+struct PaletteTable {
+  uint32_t entries[256];
+};
+
+constexpr uint32_t packColor(uint8_t r, uint8_t g, uint8_t b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+// HeatColor(), as FastLED computes it
+constexpr uint32_t heatEntry(uint8_t temperature) {
+  uint8_t t192 = (uint8_t)(((temperature * 191) >> 8) + (temperature ? 1 : 0));
+  uint8_t heatramp = (uint8_t)((t192 & 0x3F) << 2);
+  return (t192 & 0x80) ? packColor(255, 255, heatramp)
+       : (t192 & 0x40) ? packColor(255, heatramp, 0)
+       : packColor(heatramp, 0, 0);
+}
+
+// CHSV(hue, 255, 255), as FastLED's hsv2rgb_rainbow computes it
+constexpr uint32_t hueEntry(uint8_t hue) {
+  uint8_t offset8 = (uint8_t)((hue & 0x1F) << 3);
+  uint8_t third = (uint8_t)((offset8 * (1 + 256 / 3)) >> 8);
+  uint8_t twothirds = (uint8_t)((offset8 * (1 + (256 * 2) / 3)) >> 8);
+  switch (hue >> 5) {
+    case 0: return packColor(255 - third, third, 0);           // R -> O
+    case 1: return packColor(171, 85 + third, 0);              // O -> Y
+    case 2: return packColor(171 - twothirds, 170 + third, 0); // Y -> G
+    case 3: return packColor(0, 255 - third, third);           // G -> A
+    case 4: return packColor(0, 171 - twothirds, 85 + twothirds); // A -> B
+    case 5: return packColor(third, 0, 255 - third);           // B -> P
+    case 6: return packColor(85 + third, 0, 171 - third);      // P -> K
+    default: return packColor(170 + third, 0, 85 - third);     // K -> R
+  }
+}
+
+template <uint32_t (*Entry)(uint8_t)>
+constexpr PaletteTable buildPaletteTable() {
+  PaletteTable table{};
+  for (uint16_t i = 0; i < 256; i++) {
+    table.entries[i] = Entry((uint8_t)i);
+  }
+  return table;
+}
+
+extern const PaletteTable HEAT_PALETTE_TABLE;  // Heat value to color
+extern const PaletteTable HUE_PALETTE_TABLE;   // Fully saturated color wheel, index = hue
+
+// Read access to a PaletteTable in flash, same interface as PaletteLut
+class FlashPalette {
+private:
+  const uint32_t* entries;
+
+public:
+  explicit FlashPalette(const PaletteTable& table) : entries(table.entries) {}
+
+  CRGB operator[](uint8_t index) const {
+    uint32_t c = pgm_read_dword(entries + index);
+    return CRGB((uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+  }
+
+  CRGB dimmed(uint8_t index, uint8_t brightness) const {
+    return dimColor((*this)[index], brightness);
+  }
+};
+
+#endif // PALETTE_H
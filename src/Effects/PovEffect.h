@@ -0,0 +1,99 @@
+#ifndef POV_EFFECT_H
+#define POV_EFFECT_H
+
+#include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
+#include "PovImage.h"
+#include "../PowerLimiter.h"
+
+// Milliseconds per turn of the preview sweep shown while the staff is still
+#define POV_PREVIEW_TURN_MS 4000
+
+// Persistence-of-vision image effect
+// While the staff spins, LEDController asks renderColumn() for the image
+// column at the gyro's spin phase many times per frame (see servicePov()).
+// The frame update() only runs while the staff is still and slowly sweeps
+// through the columns as a preview.
+//
+// Phases are binary angles: a full turn is 2^32. The second strip sits on
+// the other side of the hilt, so it is created with a half-turn offset.
+class PovEffect : public Effect {
+private:
+  CRGB* ledArray;
+  const StaffGeometry* geometry;
+  int numLeds;
+  const PovImage* image;
+  uint32_t phaseOffset;
+  uint32_t previewPhase;
+  int16_t drawnColumn;  // Column in the array, -1 before the first frame
+  CRGB palette[16];     // Copied out of flash once
+
+public:
+  PovEffect(CRGB* leds, const StaffGeometry& geo, const PovImage& img, uint32_t offset) :
+    ledArray(leds), geometry(&geo), numLeds(geo.numLeds), image(&img), phaseOffset(offset),
+    previewPhase(0), drawnColumn(-1) {
+    for (uint8_t i = 0; i < 16; i++) {
+      palette[i] = CRGB(pgm_read_byte(img.palette + i * 3),
+                        pgm_read_byte(img.palette + i * 3 + 1),
+                        pgm_read_byte(img.palette + i * 3 + 2));
+    }
+  }
+
+  bool isInitialized() const override {
+    return ledArray != nullptr && numLeds > 0 && image->columns > 0;
+  }
+
+  // Image column facing the given spin phase
+  uint8_t columnAt(uint32_t phase) const {
+    return (((phase + phaseOffset) >> 16) * image->columns) >> 16;
+  }
+
+  // Draw a column into count LEDs running from the hilt to the tip
+  void renderColumn(uint8_t column, CRGB* out, uint8_t count) const {
+    PowerEstimate unused;
+    renderColumn(column, out, count, unused);
+  }
+
+  // Same, summing the column into a power estimate as it's drawn
+  // Image pixel i * radius / count is reached by stepping a 16.16 position;
+  // the step is rounded up, which keeps every pixel exact for counts and
+  // radii up to 255, so the only divide is once per column
+  void renderColumn(uint8_t column, CRGB* out, uint8_t count, PowerEstimate& power) const {
+    if (count == 0) {
+      return;
+    }
+    const uint8_t* pixels = image->pixels + column * (image->radius / 2);
+    uint8_t radius = image->radius;
+    uint32_t step = (((uint32_t)radius << 16) + count - 1) / count;
+    uint32_t position = 0;
+    for (uint8_t i = 0; i < count; i++, position += step) {
+      uint8_t r = position >> 16;
+      uint8_t packed = pgm_read_byte(pixels + r / 2);
+      out[i] = palette[(r & 1) ? (packed >> 4) : (packed & 0x0F)];
+      power.add(out[i]);
+    }
+  }
+
+  bool update(const FrameTime& time) override {
+    if (!isInitialized()) {
+      return false;
+    }
+
+    // 2^32 / POV_PREVIEW_TURN_MS phase per millisecond
+    previewPhase += time.dt * (uint32_t)(4294967296ULL / POV_PREVIEW_TURN_MS);
+    uint8_t column = columnAt(previewPhase);
+    if (column == drawnColumn) {
+      return false;
+    }
+
+    // Both rows of the strip show the column, mirrored at the tip
+    CRGB line[STAFF_LINE_LEDS];
+    renderColumn(column, line, STAFF_LINE_LEDS);
+    fanOutLine(line, ledArray, *geometry);
+    drawnColumn = column;
+    return true;
+  }
+};
+
+#endif // POV_EFFECT_H
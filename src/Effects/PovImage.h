@@ -0,0 +1,20 @@
+#ifndef POV_IMAGE_H
+#define POV_IMAGE_H
+
+#include <Arduino.h>
+
+// Polar image for the POV mode, stored in flash
+// Each column is one angle, with radial pixels from the hilt to the tip as
+// 4-bit palette indices, two per byte (low nibble first).
+// Generated by tools/pov_image.py.
+struct PovImage {
+  uint8_t columns;          // Angular steps per turn
+  uint8_t radius;           // Radial pixels per column (even)
+  const uint8_t* palette;   // 16 RGB entries, PROGMEM
+  const uint8_t* pixels;    // columns * radius / 2 bytes, PROGMEM
+};
+
+// The image shown by the POV mode (src/PovImages.cpp)
+extern const PovImage POV_IMAGE;
+
+#endif // POV_IMAGE_H
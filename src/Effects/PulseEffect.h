@@ -2,40 +2,61 @@
 #define PULSE_EFFECT_H
 
 #include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
+#include "Palette.h"
+
+// Milliseconds per base hue step
+#define PULSE_HUE_MS 50
+
+// Most waves setWaveCount() accepts
+#define PULSE_MAX_WAVES 8
+
+// Wave phase step per LED from the hilt; the waves all repeat every
+// PULSE_WAVE_PERIOD LEDs along the staff
+#define PULSE_WAVE_STEP 8
+#define PULSE_WAVE_PERIOD (256 / PULSE_WAVE_STEP)
 
 // Energy Pulse Effect that radiates from center outward
 // Accounts for folded LED arrangement where LED 1 and 200 are at the center/hilt,
 // and LEDs 100 and 101 are at the far end
-class PulseEffect {
+class PulseEffect : public Effect {
 private:
   CRGB* ledArray;
+  const StaffGeometry* geometry;
   int numLeds;
   uint8_t hue;
   uint8_t baseHue;
   uint8_t hueStep;
   uint8_t waveCount;
-  bool isFolded; // Whether the LED strip is folded
+  uint8_t detail;      // Quality governor detail, coarsens the wave steps
   bool initialized; // New flag to track initialization status
-  unsigned long lastUpdate; // Timestamp of last update
+  StepTimer hueTimer;  // Base hue drift
+  FlashPalette palette;  // Fully saturated color wheel, index = hue (shared, in flash)
+  bool drawn;                            // The buffer holds the state below
+  uint8_t drawnHue;
+  uint8_t drawnPhases[PULSE_MAX_WAVES];
   
 public:
-  PulseEffect(CRGB* leds, int count, bool folded = true) : 
-    ledArray(nullptr), numLeds(0), hue(0), baseHue(0), hueStep(1), 
-    waveCount(1), isFolded(folded), initialized(false), lastUpdate(0) {
+  PulseEffect(CRGB* leds, const StaffGeometry& geo) : 
+    ledArray(nullptr), geometry(&geo), numLeds(0), hue(0), baseHue(0), hueStep(1), 
+    waveCount(1), detail(255), initialized(false), hueTimer(PULSE_HUE_MS), palette(HUE_PALETTE_TABLE),
+    drawn(false), drawnHue(0), drawnPhases{} {
+    
+    int count = geo.numLeds;
     
     // Validate inputs
     if (!leds || count <= 0) {
-      Serial.println("ERROR: PulseEffect created with invalid parameters");
+      LOG_ERROR("PulseEffect created with invalid parameters");
       return;
     }
     
     ledArray = leds;
     numLeds = count;
     initialized = true;
-    lastUpdate = millis(); // Initialize the last update time
   }
   
-  bool isInitialized() const {
+  bool isInitialized() const override {
     return initialized && ledArray != nullptr && numLeds > 0;
   }
   
@@ -44,82 +65,97 @@ public:
   }
   
   void setWaveCount(uint8_t count) {
-    if (count > 0 && count <= 5) { // Reasonable bounds
+    if (count > 0 && count <= PULSE_MAX_WAVES) {
       waveCount = count;
+      drawn = false;
+    }
+  }
+  
+  void setDetail(uint8_t d) override {
+    detail = d;
+  }
+  
+  // The waves follow the clock; only the drifting hue is worth keeping
+  uint16_t saveState(uint8_t* state, uint16_t room) const override {
+    if (room < 1) {
+      return 0;
+    }
+    state[0] = baseHue;
+    return 1;
+  }
+  
+  void restoreState(const uint8_t* state, uint16_t length) override {
+    if (length == 1) {
+      baseHue = state[0];
     }
   }
   
-  void update() {
+  bool update(const FrameTime& time) override {
     // Safety check - make sure we have valid memory and initialization
     if (!isInitialized()) {
       // Log error only once to avoid console spam
       static bool errorLogged = false;
       if (!errorLogged) {
-        Serial.println("ERROR: PulseEffect update called on uninitialized effect");
+        LOG_ERROR("PulseEffect update called on uninitialized effect");
         errorLogged = true;
       }
-      return;
+      return false;
     }
     
-    // Add timing control to prevent too-rapid updates
-    unsigned long currentMillis = millis();
-    // Only update the effect every 20ms (50 updates per second)
-    if (currentMillis - lastUpdate < 20) {
-      return;
+    // Slowly change the base hue for variation
+    baseHue += hueStep * hueTimer.advance(time.dt);
+    
+    // The pattern only moves when a wave's 8-bit phase or the base hue
+    // steps, so frames in between leave the buffer alone and aren't sent.
+    // Below detail 192 the phases and hue move in steps of 2 (eco) or 4
+    // (minimal), so only every second or fourth step is rendered.
+    uint8_t stepMask = (uint8_t)(0xFF << ((255 - detail) >> 6));
+    uint8_t hueNow = baseHue & stepMask;
+    uint8_t phases[PULSE_MAX_WAVES];
+    bool changed = !drawn || hueNow != drawnHue;
+    for (uint8_t w = 1; w <= waveCount; w++) {
+      phases[w - 1] = beat8At(time.now, 10 * w) & stepMask;
+      changed |= phases[w - 1] != drawnPhases[w - 1];
+    }
+    if (!changed) {
+      return false;
     }
-    lastUpdate = currentMillis;
+    drawn = true;
+    drawnHue = hueNow;
+    memcpy(drawnPhases, phases, waveCount);
     
-    // For folded strips, both ends (LED 0 and LED count-1) are at the center
-    // and the middle of the strip (LED count/2) is at the far end
+    // Create multiple sine waves with different frequencies
+    // Creates a pulse that travels outward from the center. Every wave
+    // moves the same phase per LED, so one period of distances is summed:
+    // each wave's phase comes from the frame time (as beatsin8() would)
+    // and steps along the period in an accumulator, 1/w as strong as the first
+    uint16_t wave[PULSE_WAVE_PERIOD] = {0};  // uint16_t, the sum can pass 255
+    for (uint8_t w = 1; w <= waveCount; w++) {
+      uint8_t amplitude = 255 / w;
+      uint8_t phase = phases[w - 1];
+      for (uint8_t k = 0; k < PULSE_WAVE_PERIOD; k++) {
+        wave[k] += scale8(sin8(phase), amplitude);
+        phase += PULSE_WAVE_STEP;
+      }
+    }
     
-    uint8_t midPoint = numLeds / 2; // Physical midpoint of the strip
+    // Color depends only on the distance from the center, with the hue
+    // varying along it (same result as CHSV(hueVar, 255, brightness))
+    CRGB shade[STAFF_LINE_LEDS + 1];
+    for (uint8_t d = 0; d <= geometry->maxDistance; d++) {
+      uint16_t brightness = wave[d % PULSE_WAVE_PERIOD];
+      uint8_t hueVar = hueNow + d;
+      shade[d] = palette.dimmed(hueVar, brightness > 255 ? 255 : brightness);
+    }
     
+    // Distance from the center comes from the layout table, so folded and
+    // linear strips share the same loop
+    const uint8_t* distance = geometry->distance;
     for (int i = 0; i < numLeds; i++) {
-      // Bounds check
-      if (i < 0 || i >= numLeds) continue;
-      
-      // Calculate distance from center based on folded arrangement
-      uint8_t distanceFromCenter;
-      
-      if (isFolded) {
-        // In folded arrangement:
-        // - LEDs 0 to midPoint-1 go from center to tip
-        // - LEDs midPoint to numLeds-1 go from tip back to center
-        if (i < midPoint) {
-          distanceFromCenter = i; // First half: 0 is at center
-        } else {
-          distanceFromCenter = numLeds - 1 - i; // Second half: numLeds-1 is at center
-        }
-      } else {
-        // For standard linear arrangement
-        distanceFromCenter = abs(i - midPoint);
-      }
-      
-      // Create multiple sine waves with different frequencies
-      // Creates a pulse that travels outward from the center
-      uint16_t brightness = 0; // Use uint16_t to prevent overflow during addition
-      
-      for (uint8_t w = 1; w <= waveCount; w++) {
-        // Fix max() by making both arguments the same type (uint8_t)
-        uint8_t divisor = (w > 1) ? w : uint8_t(1);
-        uint8_t b = beatsin8(10 * w, 0, 255 / divisor, 0, distanceFromCenter * 8);
-        brightness += b;
-      }
-      
-      // Fix min() by making both arguments the same type (uint16_t)
-      brightness = (brightness > uint16_t(255)) ? uint16_t(255) : brightness;
-      
-      // Calculate hue variation based on distance from center
-      uint8_t hueVar = baseHue + distanceFromCenter;
-      
-      // Set the LED color
-      ledArray[i] = CHSV(hueVar, 255, brightness);
+      ledArray[i] = shade[distance[i]];
     }
     
-    // Slowly change the base hue for variation
-    EVERY_N_MILLISECONDS(50) {
-      baseHue += hueStep;
-    }
+    return true;
   }
 };
 
@@ -2,41 +2,79 @@
 #define RAINBOW_EFFECT_H
 
 #include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
+#include "Palette.h"
+
+// Milliseconds per animation step (the hue moves speed/4 per step)
+#define RAINBOW_STEP_MS 50
+
+// map(k, 0, steps, from, from + span) for k = 0, 1, 2..., stepped along a
+// strip without dividing: the remainder is carried from one LED to the next
+class HueRamp {
+private:
+  uint8_t value;
+  uint8_t span;
+  uint16_t steps;
+  uint16_t remainder;
+
+public:
+  HueRamp(uint8_t from, uint8_t spanHue, uint16_t stepCount) :
+    value(from), span(spanHue), steps(stepCount ? stepCount : 1), remainder(0) {}
+
+  uint8_t next() {
+    uint8_t current = value;
+    remainder += span;
+    while (remainder >= steps) {
+      remainder -= steps;
+      value++;
+    }
+    return current;
+  }
+};
 
 // Enhanced Rainbow Effect with multiple modes
 // Adapted for folded LED strip arrangement where LEDs at index 0 and (count-1) are at the center/hilt,
 // and LEDs at index (count/2-1) and (count/2) are at the far end
-class RainbowEffect {
+class RainbowEffect : public Effect {
 private:
   CRGB* ledArray;
+  const StaffGeometry* geometry;
   int numLeds;
   uint8_t mode;        // 0=smooth cycle, 1=moving rainbow, 2=twinkle
   uint8_t hue;         // Starting hue
   uint8_t saturation;
   uint8_t speed;
   uint8_t density;     // For twinkle effect
-  bool isFolded;       // Whether the LED strip is folded
+  uint8_t detail;      // Quality governor detail, thins out the twinkles
   bool initialized;    // New flag to track initialization status
-  unsigned long lastUpdate; // Timestamp of last update
+  unsigned long hueRemainder;  // Hue movement not yet applied, in (speed/4) x ms
+  StepTimer twinkleTimer;      // Fade and sparkle steps for the twinkle mode
+  PaletteLut palette;          // Color wheel at the current saturation, index = hue
+  StepTimer blendTimer;        // Palette blend steps after a saturation change
+  bool blending;
   
 public:
-  RainbowEffect(CRGB* leds, int count, bool folded = true) : 
-    ledArray(nullptr), numLeds(0), mode(0), hue(0), saturation(240), 
-    speed(30), density(50), isFolded(folded), initialized(false), lastUpdate(0) {
+  RainbowEffect(CRGB* leds, const StaffGeometry& geo) : 
+    ledArray(nullptr), geometry(&geo), numLeds(0), mode(0), hue(0), saturation(240), 
+    speed(30), density(50), detail(255), initialized(false), hueRemainder(0), twinkleTimer(RAINBOW_STEP_MS),
+    blendTimer(PALETTE_BLEND_MS), blending(false) {
+    
+    int count = geo.numLeds;
     
     // Validate inputs
     if (!leds || count <= 0) {
-      Serial.println("ERROR: RainbowEffect created with invalid parameters");
+      LOG_ERROR("RainbowEffect created with invalid parameters");
       return;
     }
     
     ledArray = leds;
     numLeds = count;
+    palette.build(HuePalette{saturation});
     initialized = true;
-    lastUpdate = millis(); // Initialize the last update time
   }
   
-  bool isInitialized() const {
+  bool isInitialized() const override {
     return initialized && ledArray != nullptr && numLeds > 0;
   }
   
@@ -44,8 +82,10 @@ public:
     if (m < 3) mode = m;
   }
   
+  // The palette blends over to the new saturation instead of jumping
   void setSaturation(uint8_t s) {
     saturation = s;
+    blending = true;
   }
   
   void setSpeed(uint8_t s) {
@@ -56,25 +96,47 @@ public:
     density = d;
   }
   
-  void update() {
+  void setDetail(uint8_t d) override {
+    detail = d;
+  }
+  
+  uint16_t saveState(uint8_t* state, uint16_t room) const override {
+    if (room < 1) {
+      return 0;
+    }
+    state[0] = hue;
+    return 1;
+  }
+  
+  void restoreState(const uint8_t* state, uint16_t length) override {
+    if (length == 1) {
+      hue = state[0];
+    }
+  }
+  
+  bool update(const FrameTime& time) override {
     // Safety check - make sure we have valid memory and initialization
     if (!isInitialized()) {
       // Log error only once to avoid console spam
       static bool errorLogged = false;
       if (!errorLogged) {
-        Serial.println("ERROR: RainbowEffect update called on uninitialized effect");
+        LOG_ERROR("RainbowEffect update called on uninitialized effect");
         errorLogged = true;
       }
-      return;
+      return false;
     }
     
-    // Add timing control to prevent too-rapid updates
-    unsigned long currentMillis = millis();
-    // Only update the effect every 20ms (50 updates per second)
-    if (currentMillis - lastUpdate < 20) {
-      return;
+    // The hue moves speed/4 every RAINBOW_STEP_MS, carrying the remainder
+    // so it runs at the same rate at any frame interval
+    hueRemainder += time.dt * (speed / 4);
+    hue += hueRemainder / RAINBOW_STEP_MS;
+    hueRemainder %= RAINBOW_STEP_MS;
+
+    if (blending) {
+      for (uint8_t steps = blendTimer.advance(time.dt); steps > 0 && blending; steps--) {
+        blending = palette.blendToward(HuePalette{saturation}, PALETTE_BLEND_STEP);
+      }
     }
-    lastUpdate = currentMillis;
     
     switch (mode) {
       case 0: // Smooth cycle - entire strip changes color together
@@ -85,59 +147,53 @@ public:
         updateMovingRainbow();
         break;
         
-      case 2: // Rainbow twinkle - random pixels change with rainbow hues
-        updateRainbowTwinkle();
+      case 2: { // Rainbow twinkle - random pixels change with rainbow hues
+        uint8_t steps = twinkleTimer.advance(time.dt);
+        if (steps == 0) {
+          return false;
+        }
+        while (steps--) {
+          updateRainbowTwinkle();
+        }
         break;
+      }
     }
     
-    // Update hue slowly for next frame
-    hue += (speed / 4);
+    return true;
   }
   
 private:
   void updateSmoothCycle() {
     // Fill the entire strip with a single changing color
-    fill_solid(ledArray, numLeds, CHSV(hue, saturation, 255));
+    fill_solid(ledArray, numLeds, palette[hue]);
   }
   
   void updateMovingRainbow() {
     // Safety check again
     if (!isInitialized()) return;
     
-    uint8_t midPoint = numLeds / 2;
-    
-    if (isFolded) {
-      // For folded arrangement, we want the rainbow to flow from center outward
-      // or from one end to the other consistently
+    if (geometry->layout != LAYOUT_LINEAR) {
+      // For folded arrangement, the rainbow flows continuously along the strip:
+      // half the color wheel from center to far end, the other half back to center
+      // (a hilt-to-tip line only has the first half)
+      int midPoint = geometry->halfLength;
       
-      // Calculate appropriate hue delta to make the pattern continuous
-      uint8_t hueSpread = 128; // Half the color wheel
-      
-      // First half - from center to far end
+      // First half - from center to far end, 0..128
+      HueRamp out(0, 128, midPoint - 1);
       for (int i = 0; i < midPoint; i++) {
-        uint8_t pos = i;
-        uint8_t hueVal = hue + map(pos, 0, midPoint - 1, 0, hueSpread);
-        if (i >= 0 && i < numLeds) { // Bounds check
-          ledArray[i] = CHSV(hueVal, saturation, 255);
-        }
+        ledArray[i] = palette[uint8_t(hue + out.next())];
       }
       
-      // Second half - from far end back to center
-      // Continue the pattern from where first half ended
+      // Second half - from far end back to center, 128..255
+      HueRamp back(128, 127, midPoint - 1);
       for (int i = midPoint; i < numLeds; i++) {
-        uint8_t pos = i - midPoint;
-        uint8_t hueVal = hue + map(pos, 0, midPoint - 1, hueSpread, 255);
-        if (i >= 0 && i < numLeds) { // Bounds check
-          ledArray[i] = CHSV(hueVal, saturation, 255);
-        }
+        ledArray[i] = palette[uint8_t(hue + back.next())];
       }
     } else {
       // Standard moving rainbow for non-folded arrangement
       uint8_t deltaHue = 255 / numLeds; // Calculate hue change per LED
       for (int i = 0; i < numLeds; i++) {
-        if (i >= 0 && i < numLeds) { // Bounds check
-          ledArray[i] = CHSV(hue + (i * deltaHue), saturation, 255);
-        }
+        ledArray[i] = palette[uint8_t(hue + (i * deltaHue))];
       }
     }
   }
@@ -148,36 +204,27 @@ private:
     
     // Fade all LEDs slightly each frame
     for (int i = 0; i < numLeds; i++) {
-      if (i >= 0 && i < numLeds) { // Bounds check
-        ledArray[i].fadeToBlackBy(10);
-      }
+      ledArray[i].fadeToBlackBy(10);
+    }
+    
+    // Use uint8_t for division to avoid type mismatches
+    uint8_t probability = density / uint8_t(10);
+    if (detail < 255) {
+      probability = scale8(probability, detail);
     }
     
+    // Use a position-dependent hue (0-128 from center to tip) for a more
+    // organized look if folded; linear strips use no position hue
+    uint8_t hueSpread = (geometry->layout != LAYOUT_LINEAR) ? 128 : 0;
+    int midPoint = geometry->halfLength;
+    const uint8_t* distance = geometry->distance;
+    
     // Randomly light new LEDs
     for (int i = 0; i < numLeds; i++) {
-      // Use uint8_t for division to avoid type mismatches
-      uint8_t probability = density / uint8_t(10);
       if (random8() < probability) { // Adjust probability based on density
-        // Use a position-dependent hue for a more organized look if folded
-        uint8_t positionHue;
-        if (isFolded) {
-          uint8_t midPoint = numLeds / 2;
-          // Calculate distance from center (0 to midPoint)
-          uint8_t distFromCenter;
-          if (i < midPoint) {
-            distFromCenter = i;
-          } else {
-            distFromCenter = numLeds - 1 - i;
-          }
-          // Map distance to hue (0-255)
-          positionHue = map(distFromCenter, 0, midPoint, 0, 128);
-        } else {
-          positionHue = 0;
-        }
-        
-        if (i >= 0 && i < numLeds) { // Bounds check
-          ledArray[i] = CHSV(hue + positionHue + random8(64), saturation, 255);
-        }
+        // Only the few new sparkles pay for this divide
+        uint8_t positionHue = (distance[i] * hueSpread) / midPoint;
+        ledArray[i] = palette[uint8_t(hue + positionHue + random8(64))];
       }
     }
   }
@@ -0,0 +1,57 @@
+#ifndef SOLID_EFFECT_H
+#define SOLID_EFFECT_H
+
+#include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
+
+// Milliseconds per hue step
+#define SOLID_HUE_MS 100
+
+// Solid color effect - the whole strip shows one slowly changing hue
+class SolidEffect : public Effect {
+private:
+  CRGB* ledArray;
+  int numLeds;
+  unsigned long elapsed;  // Milliseconds since the effect started
+  int16_t drawnHue;       // Hue currently in the array, -1 before the first frame
+
+public:
+  SolidEffect(CRGB* leds, const StaffGeometry& geo) : ledArray(leds), numLeds(geo.numLeds), elapsed(0), drawnHue(-1) {}
+
+  bool isInitialized() const override {
+    return ledArray != nullptr && numLeds > 0;
+  }
+
+  uint16_t saveState(uint8_t* state, uint16_t room) const override {
+    if (room < sizeof(elapsed)) {
+      return 0;
+    }
+    memcpy(state, &elapsed, sizeof(elapsed));
+    return sizeof(elapsed);
+  }
+
+  void restoreState(const uint8_t* state, uint16_t length) override {
+    if (length == sizeof(elapsed)) {
+      memcpy(&elapsed, state, sizeof(elapsed));
+    }
+  }
+
+  bool update(const FrameTime& time) override {
+    if (!isInitialized()) {
+      return false;
+    }
+
+    // One hue step every SOLID_HUE_MS, only redrawn when it moves
+    elapsed += time.dt;
+    uint8_t hue = (elapsed / SOLID_HUE_MS) & 0xFF;
+    if (hue == drawnHue) {
+      return false;
+    }
+    fill_solid(ledArray, numLeds, CHSV(hue, 255, 255));
+    drawnHue = hue;
+    return true;
+  }
+};
+
+#endif // SOLID_EFFECT_H
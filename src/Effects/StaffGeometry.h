@@ -0,0 +1,83 @@
+#ifndef STAFF_GEOMETRY_H
+#define STAFF_GEOMETRY_H
+
+#include <FastLED.h>
+#include "../version.h"
+
+// Physical layout of one LED strip, precomputed per LED index
+// Effects look positions up here instead of working them out per pixel,
+// so the render loops have no layout branches or divisions.
+// See docs/led-arrangement.md for the folded layout.
+
+#define STAFF_STRIP_LEDS LED_COUNT_PER_STRIP
+#define STAFF_LINE_LEDS (STAFF_STRIP_LEDS / 2)  // Hilt to tip
+
+static_assert(STAFF_STRIP_LEDS / 2 <= 255, "Distances are stored as 8-bit values");
+
+enum StaffLayout {
+  LAYOUT_FOLDED = 0,  // Up one side of the tube and back: 0 and N-1 at the hilt, N/2-1 and N/2 at the tip
+  LAYOUT_LINEAR = 1,  // Straight strip centered on the hilt between N/2-1 and N/2
+  LAYOUT_LINE = 2     // One logical hilt-to-tip line of N/2 LEDs, fanned out by fanOutLine()
+};
+
+struct StaffGeometry {
+  StaffLayout layout;
+  uint16_t numLeds;
+  uint8_t halfLength;                   // Split point between the two sides
+  bool folded;
+  uint8_t maxDistance;                  // Farthest pixel from the hilt
+  uint8_t distance[STAFF_STRIP_LEDS];   // LEDs between this pixel and the hilt
+};
+
+constexpr StaffGeometry buildStaffGeometry(StaffLayout layout) {
+  StaffGeometry g{};
+  g.layout = layout;
+  g.numLeds = (layout == LAYOUT_LINE) ? STAFF_LINE_LEDS : STAFF_STRIP_LEDS;
+  g.halfLength = (layout == LAYOUT_LINE) ? STAFF_LINE_LEDS : STAFF_STRIP_LEDS / 2;
+  g.folded = (layout == LAYOUT_FOLDED);
+
+  uint8_t maxDistance = 0;
+  for (int i = 0; i < g.numLeds; i++) {
+    int d = 0;
+    if (layout == LAYOUT_FOLDED) {
+      // LEDs 0..half-1 run from hilt to tip, half..N-1 run back to the hilt
+      d = (i < g.halfLength) ? i : (STAFF_STRIP_LEDS - 1 - i);
+    } else if (layout == LAYOUT_LINEAR) {
+      // Mirrored about the hilt like the folded layout: N/2-1 and N/2 are
+      // both next to it, 0 and N-1 both at the ends
+      d = (i < g.halfLength) ? (g.halfLength - 1 - i) : (i - g.halfLength);
+    } else {
+      d = i;
+    }
+    g.distance[i] = (uint8_t)d;
+    if (d > maxDistance) maxDistance = (uint8_t)d;
+  }
+
+  g.maxDistance = maxDistance;
+
+  return g;
+}
+
+// Tables are built by the compiler; one copy per layout is shared by all
+// effects, and layouts that are never referenced take no RAM
+template <StaffLayout Layout>
+inline const StaffGeometry& staffGeometry() {
+  static constexpr StaffGeometry table = buildStaffGeometry(Layout);
+  return table;
+}
+
+// fanOutLine() indexes the line by distance, so no layout may reach past it
+static_assert(buildStaffGeometry(LAYOUT_FOLDED).maxDistance < STAFF_LINE_LEDS, "Folded distances overrun the line");
+static_assert(buildStaffGeometry(LAYOUT_LINEAR).maxDistance < STAFF_LINE_LEDS, "Linear distances overrun the line");
+static_assert(buildStaffGeometry(LAYOUT_LINE).maxDistance < STAFF_LINE_LEDS, "Line distances overrun the line");
+
+// Copy a hilt-to-tip line (LAYOUT_LINE) onto a physical strip, mirroring it
+// wherever the strip's layout puts the same distance from the hilt twice
+inline void fanOutLine(const CRGB* line, CRGB* strip, const StaffGeometry& geometry) {
+  const uint8_t* distance = geometry.distance;
+  for (int i = 0; i < geometry.numLeds; i++) {
+    strip[i] = line[distance[i]];
+  }
+}
+
+#endif // STAFF_GEOMETRY_H
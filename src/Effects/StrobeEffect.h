@@ -2,18 +2,20 @@
 #define STROBE_EFFECT_H
 
 #include <FastLED.h>
+#include "Effect.h"
+#include "StaffGeometry.h"
 
 // Advanced Strobe Effect with multi-mode capabilities
-class StrobeEffect {
+class StrobeEffect : public Effect {
 private:
   CRGB* ledArray;
+  const StaffGeometry* geometry;
   int numLeds;
   uint8_t mode;      // 0=white strobe, 1=color strobe, 2=lightning
   uint8_t speed;     // Controls flash frequency
   uint8_t duty;      // Duty cycle (ratio of on vs off time)
   CRGB color;        // Color for colored strobe mode
   bool active;       // Current state of the strobe
-  bool isFolded;     // Whether the LED strip is folded
   uint8_t flashMaxBrightness; // Maximum brightness for flash (to prevent power issues)
   bool initialized;  // New flag to track initialization status
   
@@ -22,21 +24,21 @@ private:
   bool flashOn;
   
 public:
-  StrobeEffect(CRGB* leds, int count, bool folded = true) : 
-    ledArray(leds), numLeds(count), mode(0), speed(50), duty(10),
-    color(CRGB::White), active(false), isFolded(folded), 
+  StrobeEffect(CRGB* leds, const StaffGeometry& geo) : 
+    ledArray(leds), geometry(&geo), numLeds(geo.numLeds), mode(0), speed(50), duty(10),
+    color(CRGB::White), active(false), 
     flashMaxBrightness(25), initialized(true),
     lastFlashChange(0), flashOn(false) {
     
     // Validate inputs
-    if (!leds || count <= 0) {
-      Serial.println("ERROR: StrobeEffect created with invalid parameters");
+    if (!leds || numLeds <= 0) {
+      LOG_ERROR("StrobeEffect created with invalid parameters");
       initialized = false;
       return;
     }
   }
   
-  bool isInitialized() const {
+  bool isInitialized() const override {
     return initialized && ledArray != nullptr && numLeds > 0;
   }
   
@@ -62,15 +64,15 @@ public:
     flashMaxBrightness = brightness;
   }
   
-  void update() {
+  bool update(const FrameTime& time) override {
     // Safety check - make sure we have valid memory and initialization
     if (!isInitialized()) {
-      return;
+      return false;
     }
     
     // Use a fixed, very slow strobe rate to debug the issue
     // 500ms on, 500ms off
-    unsigned long currentMillis = millis();
+    unsigned long currentMillis = time.now;
     unsigned long interval = 500; // Fixed 500ms interval for debugging
     
     // Check if it's time to change the flash state
@@ -83,7 +85,11 @@ public:
       
       // Fill the entire strip with the target color
       fill_solid(ledArray, numLeds, targetColor);
+      return true;
     }
+    
+    // Nothing changes between flash state changes
+    return false;
   }
 };
 
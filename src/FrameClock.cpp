@@ -0,0 +1,91 @@
+#include "BoStaff.h"
+
+bool FrameClock::due() const {
+  return !started || (micros() - lastFrameMicros >= targetInterval);
+}
+
+/**
+ * Start a frame: timestamp it for the effects and record the interval
+ * since the previous one
+ */
+FrameTime FrameClock::beginFrame() {
+  unsigned long nowMicros = micros();
+  unsigned long nowMillis = millis();
+  FrameTime time = { nowMillis, 0 };
+  
+  if (started) {
+    unsigned long interval = nowMicros - lastFrameMicros;
+    time.dt = nowMillis - lastFrameMillis;
+    
+    if (interval < minInterval) minInterval = interval;
+    if (interval > maxInterval) maxInterval = interval;
+    intervalSum += interval;
+    frameCount++;
+    if (interval > targetInterval + targetInterval / 2) {
+      overruns++;
+    }
+  }
+  
+  started = true;
+  lastFrameMicros = nowMicros;
+  lastFrameMillis = nowMillis;
+  frameStartMicros = nowMicros;
+  return time;
+}
+
+/**
+ * Measure what the frame cost and pace the next one accordingly
+ * The cost follows increases right away and decays slowly, so frames that
+ * skipped show() don't pull the interval below what a full frame needs.
+ * transientMicros is work that only lasts a moment (a crossfade); it's
+ * bounded by the caller to fit in the headroom and left out of the cost.
+ */
+void FrameClock::endFrame(unsigned long transientMicros) {
+  unsigned long cost = micros() - frameStartMicros;
+  cost -= (transientMicros < cost) ? transientMicros : cost;
+  if (cost > frameCost) {
+    frameCost = cost;
+  } else {
+    frameCost -= (frameCost - cost) / 16;
+  }
+  
+  targetInterval = constrain(frameCost * FRAME_COST_HEADROOM,
+                             intervalFloor,
+                             (unsigned long)FRAME_MAX_INTERVAL_US);
+}
+
+/**
+ * Cap the frame rate: the interval still adapts to the cost, but never
+ * goes below this
+ */
+void FrameClock::setMinInterval(unsigned long intervalUs) {
+  intervalFloor = constrain(intervalUs, (unsigned long)FRAME_MIN_INTERVAL_US,
+                            (unsigned long)FRAME_MAX_INTERVAL_US);
+  if (targetInterval < intervalFloor) {
+    targetInterval = intervalFloor;
+  }
+}
+
+void FrameClock::resetStats() {
+  minInterval = ~0UL;
+  maxInterval = 0;
+  intervalSum = 0;
+  frameCount = 0;
+  overruns = 0;
+}
+
+/**
+ * Print frame interval statistics since the last call and start over
+ */
+void FrameClock::printStats() {
+  if (frameCount == 0) {
+    LOG_INFO("Frames: none");
+    return;
+  }
+  
+  LOG_INFO("Frames: %lu, interval min/avg/max: %lu/%lu/%lu us, target: %lu us, overruns: %lu",
+           (unsigned long)frameCount, minInterval, (unsigned long)(intervalSum / frameCount),
+           maxInterval, targetInterval, (unsigned long)overruns);
+  
+  resetStats();
+}
@@ -0,0 +1,78 @@
+#include "BoStaff.h"
+
+#define LATENCY_BAR_WIDTH 30
+
+/**
+ * Add one impact's timestamps to the histogram and the stage averages
+ */
+void ImpactLatency::record(const ImpactTiming& timing) {
+  unsigned long total = timing.showEndMicros - timing.sampleMicros;
+  unsigned long bucket = total / LATENCY_BUCKET_US;
+  if (bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  if (histogram[bucket] < 0xFFFF) {
+    histogram[bucket]++;
+  }
+  
+  count++;
+  if (total > maxTotal) {
+    maxTotal = total;
+  }
+  detectSum += timing.detectMicros - timing.sampleMicros;
+  showStartSum += timing.showStartMicros - timing.sampleMicros;
+  showEndSum += total;
+}
+
+void ImpactLatency::reset() {
+  memset(histogram, 0, sizeof(histogram));
+  count = 0;
+  maxTotal = 0;
+  detectSum = 0;
+  showStartSum = 0;
+  showEndSum = 0;
+}
+
+/**
+ * Print the latency histogram since the last call and start over
+ *
+ *   Impact latency: 12 impacts, avg from sample: detect 1210 / show start 1340 / show end 4410 us, max 7020 us
+ *    3 ms |##############################  8
+ *    4 ms |###########                     3
+ */
+void ImpactLatency::print() {
+  if (count == 0) {
+    Serial.println(F("Impact latency: no impacts"));
+    return;
+  }
+  
+  Serial.print(F("Impact latency: ")); Serial.print(count);
+  Serial.print(F(" impacts, avg from sample: detect "));
+  Serial.print((unsigned long)(detectSum / count));
+  Serial.print(F(" / show start ")); Serial.print((unsigned long)(showStartSum / count));
+  Serial.print(F(" / show end ")); Serial.print((unsigned long)(showEndSum / count));
+  Serial.print(F(" us, max ")); Serial.print(maxTotal); Serial.println(F(" us"));
+  
+  uint16_t peak = 0;
+  uint8_t first = LATENCY_BUCKETS;
+  uint8_t last = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+    if (histogram[i] == 0) continue;
+    if (histogram[i] > peak) peak = histogram[i];
+    if (first == LATENCY_BUCKETS) first = i;
+    last = i;
+  }
+  
+  for (uint8_t i = first; i <= last; i++) {
+    uint8_t width = (uint32_t)histogram[i] * LATENCY_BAR_WIDTH / peak;
+    if (i < 10) Serial.print(' ');
+    Serial.print(i * LATENCY_BUCKET_US / 1000);
+    Serial.print(i == LATENCY_BUCKETS - 1 ? F("+ms |") : F(" ms |"));
+    for (uint8_t b = 0; b < LATENCY_BAR_WIDTH; b++) {
+      Serial.print(b < width ? '#' : ' ');
+    }
+    Serial.print(F("  ")); Serial.println(histogram[i]);
+  }
+  
+  reset();
+}
@@ -1,148 +1,463 @@
 #include "BoStaff.h"
+#include "Ws2812Encoder.h"
+#include "Crossfade.h"
+
+// Crossfade length; only used with a second layer, so never 0
+static const unsigned long TRANSITION_MS = EFFECT_LAYERS > 1 ? EFFECT_TRANSITION_MS : 1;
 
 void LEDController::begin(Config* cfg) {
   config = cfg;
   currentMode = config->currentMode;
   
   // Setup the LED strips with the updated pin assignments
+#if LED_OUTPUT_ASYNC
+  // Strip 2 is clocked out by UART1 in the background, see AsyncLedOutput.cpp
+  strip1Output = &FastLED.addLeds<WS2812B, LED_PIN_1, GRB>(leds1, NUM_LEDS_PER_STRIP).setCorrection(TypicalLEDStrip);
+  strip2Output.begin();
+#else
   FastLED.addLeds<WS2812B, LED_PIN_1, GRB>(leds1, NUM_LEDS_PER_STRIP).setCorrection(TypicalLEDStrip);
   FastLED.addLeds<WS2812B, LED_PIN_2, GRB>(leds2, NUM_LEDS_PER_STRIP).setCorrection(TypicalLEDStrip);
+#endif
+  // No temporal dithering: the UART strip can't do it, so strip 1 would
+  // look different at low brightness, and unchanged frames aren't resent
+  // for it to work with anyway
+  FastLED.setDither(DISABLE_DITHER);
   
   // Set initial brightness (reduced to 25, approximately 10% of max 255)
   normalBrightness = config->brightness;
   FastLED.setBrightness(normalBrightness);
   
-  // Clear the LEDs to start
-  fill_solid(leds1, NUM_LEDS_PER_STRIP, CRGB::Black);
-  fill_solid(leds2, NUM_LEDS_PER_STRIP, CRGB::Black);
-  FastLED.show();
+  // The buffers start black; nothing is sent until the first frame, which
+  // follows straight away
+  fill(CRGB::Black);
+  
+  // Asymmetric effects render into their layer's strip buffers,
+  // symmetric ones into its hilt-to-tip line
+  for (uint8_t l = 0; l < EFFECT_LAYERS; l++) {
+    EffectLayer& layer = layers[l];
+    fill_solid(&layer.strips[0][0], TOTAL_LEDS, CRGB::Black);
+    fill_solid(layer.line, STAFF_LINE_LEDS, CRGB::Black);
+    layer.effects.begin(layer.strips[0], layer.strips[1], layer.line);
+  }
   
   // Initialize effect variables
-  effectStep = 0;
   effectSpeed = 30; // Default speed
   impactEffectActive = false;
   
-  Serial.println("LED Controller initialized");
-  Serial.print("Brightness set to: "); Serial.println(normalBrightness);
-  Serial.print("Impact brightness set to: "); Serial.println(config->impactBrightness);
 }
 
-void LEDController::update() {
-  // Always synchronize both strips in an atomic operation
-  noInterrupts();
+/**
+ * Render the next frame and send it if anything changed
+ * Effects report whether they touched their buffers, so frames where the
+ * animation didn't step (strobe between flashes, effect timing gates, the
+ * held impact flash) skip the show() entirely
+ */
+bool LEDController::update(const FrameTime& time) {
+  transitionCost = 0;
   
-  unsigned long currentMillis = millis();
-  
-  // Handle impact effect if active
-  if (impactEffectActive) {
-    if (currentMillis - impactEffectStart >= config->impactFlashDuration) {
-      // Impact effect is over, restore normal brightness
-      impactEffectActive = false;
-      FastLED.setBrightness(normalBrightness);
-      
-      // Clear both strips after impact to prevent any artifacts
-      fill_solid(leds1, NUM_LEDS_PER_STRIP, CRGB::Black);
-      fill_solid(leds2, NUM_LEDS_PER_STRIP, CRGB::Black);
-    } else {
-      // Show impact effect (dim white flash)
-      FastLED.setBrightness(config->impactBrightness); // Use the impact-specific brightness
-      
-      // Use dimmer white (25, 25, 25) instead of full white (255, 255, 255)
-      // This ensures the color itself is also dimmer, not just the overall brightness
-      CRGB dimWhite = CRGB(25, 25, 25);
-      fill_solid(leds1, NUM_LEDS_PER_STRIP, dimWhite);
-      fill_solid(leds2, NUM_LEDS_PER_STRIP, dimWhite);
+  if (impactEffectActive && time.now - impactEffectStart >= config->impactFlashDuration) {
+    impactEffectActive = false;
+    
+    if (povSpinning) {
+      // Hand the strips back to the POV columns with the returning row dark
+      fill(CRGB::Black);
+      show();
+      return true;
     }
-  } else {
-    // For compatibility with old code, we'll keep the solid color effect here
-    if (currentMode == EFFECT_SOLID) {
-      updateSolidEffect();
+  }
+  
+  // While spinning in POV mode the columns go out through servicePov()
+  if (povSpinning && !impactEffectActive) {
+    return false;
+  }
+  
+  // Render the active effect
+  bool changed;
+  {
+    PROFILE_SCOPE(PROFILE_EFFECTS);
+    EffectLayer& layer = layers[front];
+    changed = renderLayer(layer, time);
+    
+    if (transitionActive && time.now - transitionStart >= TRANSITION_MS) {
+      endTransition();
     }
     
-    // Increment effect step for animations (only when not in impact effect)
-    effectStep++;
+    // Overlays change with their envelope, so they're recomposed every frame
+    bool overlaid = compositor.begin(time.now);
+    
+    if (transitionActive) {
+      composeTransition(time);
+      if (overlaid) {
+        composeOverlays(false);
+      }
+      changed = true;
+    } else if (overlaid) {
+      composeOverlays(true);
+      changed = true;
+    } else if (changed || stripsOverwritten) {
+      power.reset();
+      copyPixels(layer.strips[0], leds1, NUM_LEDS_PER_STRIP, power);
+      copyPixels(layer.strips[1], leds2, NUM_LEDS_PER_STRIP, power);
+      stripsOverwritten = false;
+      changed = true;
+    }
   }
   
-  // Always update the LEDs at the end, regardless of impact effect state
-  FastLED.show();
+  // Brightness is applied at output time, so a change needs a resend too
+  if (changed || FastLED.getBrightness() != shownBrightness) {
+    frameDirty = true;
+  }
   
-  // Re-enable interrupts
-  interrupts();
+  if (!frameDirty) {
+    return false;
+  }
+  
+  show();
+  return true;
+}
+
+/**
+ * Lay this frame's overlays over the front layer in one pass, or
+ * mid-crossfade over the blend already in the strips
+ * The strips then differ from the layer, so they're recomposed once the
+ * overlays are gone
+ */
+void LEDController::composeOverlays(bool fromLayer) {
+  const EffectLayer& layer = layers[front];
+  power.reset();
+  compositor.apply(fromLayer ? layer.strips[0] : leds1, leds1, NUM_LEDS_PER_STRIP, power);
+  compositor.apply(fromLayer ? layer.strips[1] : leds2, leds2, NUM_LEDS_PER_STRIP, power);
+  stripsOverwritten = true;
+}
+
+/**
+ * Render one layer's effect, fanning symmetric effects out from the line
+ * to the layer's strips
+ * Returns true if the strips changed
+ */
+bool LEDController::renderLayer(EffectLayer& layer, const FrameTime& time) {
+  bool changed = layer.effects.update(time);
+  
+  if (changed && layer.effects.rendersLine()) {
+    // Fan the line out to the four half-strips; both strips share the
+    // folded layout, so the second is a straight copy of the first
+    fanOutLine(layer.line, layer.strips[0], staffGeometry<LAYOUT_FOLDED>());
+    memcpy(layer.strips[1], layer.strips[0], sizeof(layer.strips[0]));
+  }
+  return changed;
+}
+
+/**
+ * Crossfade frame: run the previous mode on the back layer as well and
+ * blend the two into the strips
+ * The extra time is measured and kept out of the frame clock's cost; a
+ * frame where it exceeds TRANSITION_MAX_COST_US ends the fade, so a
+ * transition can't stretch the frame interval
+ */
+void LEDController::composeTransition(const FrameTime& time) {
+  unsigned long start = micros();
+  EffectLayer& incoming = layers[front];
+  EffectLayer& outgoing = layers[(front + 1) % EFFECT_LAYERS];
+  renderLayer(outgoing, time);
+  
+  uint16_t amount = (time.now - transitionStart) * CROSSFADE_FULL / TRANSITION_MS;
+  power.reset();
+  crossfadePixels(outgoing.strips[0], incoming.strips[0], leds1, NUM_LEDS_PER_STRIP, amount, power);
+  crossfadePixels(outgoing.strips[1], incoming.strips[1], leds2, NUM_LEDS_PER_STRIP, amount, power);
+  stripsOverwritten = false;
+  
+  transitionCost = micros() - start;
+  transitionCostSum += transitionCost;
+  transitionFrames++;
+  if (transitionCost > transitionCostMax) {
+    transitionCostMax = transitionCost;
+  }
+  
+  if (transitionCost > TRANSITION_MAX_COST_US) {
+    LOG_WARN("Crossfade frame took %lu us, cut short", transitionCost);
+    endTransition();
+  }
+}
+
+/**
+ * Drop the outgoing mode; the next frame shows the current one alone
+ */
+void LEDController::endTransition() {
+  layers[(front + 1) % EFFECT_LAYERS].effects.release();
+  transitionActive = false;
+  stripsOverwritten = true;
+  
+  if (transitionFrames > 0) {
+    LOG_DEBUG("Crossfade: %u frames, extra cost avg/max %lu/%lu us", transitionFrames,
+              (unsigned long)(transitionCostSum / transitionFrames), transitionCostMax);
+  }
+}
+
+/**
+ * Push both strip buffers out
+ * With async output only strip 1 is bit-banged and strip 2 is queued to
+ * UART1, see output() for the order
+ */
+void LEDController::show(bool preempt) {
+  PROFILE_SCOPE(PROFILE_SHOW);
+  shownBrightness = FastLED.getBrightness();
+  frameDirty = false;
+  output(NUM_LEDS_PER_STRIP, preempt);
+}
+
+/**
+ * Impact fast path: compose the flash and send it now instead of at the
+ * next frame, cutting short any strip 2 frame still on the wire
+ */
+void LEDController::showImpact(ImpactTiming& timing) {
+  triggerImpactEffect();
+  compositor.begin(impactEffectStart);
+  composeOverlays(!transitionActive);
+  
+  timing.showStartMicros = micros();
+  show(true);
+  timing.showEndMicros = micros();
+}
+
+/**
+ * Fill both strips' buffers with one color, for status displays outside
+ * the effects (calibration); the next frame recomposes the effect
+ */
+void LEDController::fill(const CRGB& color) {
+  fill_solid(leds1, NUM_LEDS_PER_STRIP, color);
+  fill_solid(leds2, NUM_LEDS_PER_STRIP, color);
+  power.reset();
+  power.add(color, TOTAL_LEDS);
+  stripsOverwritten = true;
+}
+
+/**
+ * Send the first count LEDs of each strip
+ * WS2812s pass on whatever follows the first count pixels, so the LEDs
+ * beyond keep their last colour. The brightness is limited so the current
+ * estimated while composing the strips stays within the power budget.
+ */
+void LEDController::output(uint16_t count, bool preempt) {
+  uint8_t requested = FastLED.getBrightness();
+  uint8_t brightness = limitBrightness(power, requested, TOTAL_LEDS, powerBudget);
+  
+  uint32_t milliamps = power.milliamps(brightness, TOTAL_LEDS);
+  powerOutputs++;
+  powerSumMa += milliamps;
+  if (milliamps > powerMaxMa) powerMaxMa = milliamps;
+  if (brightness < requested) powerLimited++;
+  
+#if LED_OUTPUT_ASYNC
+  // FastLED re-enables interrupts between strip 1's pixels, but gives the
+  // frame up (after two retries) if one takes more than a few us, and the
+  // UART1 refill takes longer than that. So strip 1 goes out while UART1
+  // is idle, and strip 2 then clocks out in the background while the next
+  // frame renders.
+  strip2Output.waitIdle(preempt);
+  if (count == NUM_LEDS_PER_STRIP) {
+    strip1Output->showLeds(brightness);
+  } else {
+    strip1Output->setLeds(leds1, count);
+    strip1Output->showLeds(brightness);
+    strip1Output->setLeds(leds1, NUM_LEDS_PER_STRIP);
+  }
+  strip2Output.show(leds2, count, ws2812Adjustment(brightness, CRGB(TypicalLEDStrip)));
+#else
+  // FastLED blocks until both strips are out, so there's nothing to preempt
+  if (count == NUM_LEDS_PER_STRIP) {
+    FastLED.show(brightness);
+  } else {
+    FastLED[0].setLeds(leds1, count);
+    FastLED[1].setLeds(leds2, count);
+    FastLED.show(brightness);
+    FastLED[0].setLeds(leds1, NUM_LEDS_PER_STRIP);
+    FastLED[1].setLeds(leds2, NUM_LEDS_PER_STRIP);
+  }
+#endif
+}
+
+/**
+ * Persistence-of-vision fast path, called every loop() in POV mode
+ * While the staff spins the frame update() stands aside and the column
+ * facing the current spin phase is sent here as soon as it changes. Only
+ * the outgoing row (the first STAFF_LINE_LEDS of each strip) carries the
+ * image; the returning row is blanked when spinning starts, which halves
+ * the time per column.
+ */
+void LEDController::servicePov(bool spinning, uint32_t phase) {
+  PovEffect* pov1 = static_cast<PovEffect*>(layers[front].effects.instance(0));
+  PovEffect* pov2 = static_cast<PovEffect*>(layers[front].effects.instance(1));
+  if (!pov1 || !pov2) {
+    return;
+  }
+  
+  if (spinning != povSpinning) {
+    povSpinning = spinning;
+    povColumn = -1;
+    
+    // Blank everything; once the staff stops the preview redraws both rows
+    fill(CRGB::Black);
+    show();
+    return;
+  }
+  
+  // The impact flash takes over the strips through the frame update()
+  if (!povSpinning || impactEffectActive) {
+    return;
+  }
+  
+  uint8_t column = pov1->columnAt(phase);
+  if (column == povColumn) {
+    return;
+  }
+  
+  if (povColumn >= 0) {
+    // Columns between the last one sent and this one were never shown
+    int16_t step = (int16_t)column - povColumn;
+    int16_t columns = POV_IMAGE.columns;
+    if (step < 0) step = -step;
+    if (step > columns / 2) step = columns - step;
+    if (step > 1) povSkipped += step - 1;
+  }
+  povColumn = column;
+  povColumns++;
+  
+  // The returning rows are dark, so the columns are all that's lit
+  power.reset();
+  pov1->renderColumn(column, leds1, STAFF_LINE_LEDS, power);
+  pov2->renderColumn(pov2->columnAt(phase), leds2, STAFF_LINE_LEDS, power);
+  output(STAFF_LINE_LEDS, false);
+}
+
+void LEDController::printPovStats() {
+  LOG_INFO("POV: %s, columns %lu, skipped %lu", povSpinning ? "spinning" : "still",
+           (unsigned long)povColumns, (unsigned long)povSkipped);
+  povColumns = 0;
+  povSkipped = 0;
+}
+
+void LEDController::printPowerStats() {
+  if (powerOutputs == 0) {
+    return;
+  }
+  LOG_INFO("Power: estimate avg/max %lu/%lu mA, budget %u mA, limited %lu of %lu outputs",
+           (unsigned long)(powerSumMa / powerOutputs), (unsigned long)powerMaxMa, powerBudget,
+           (unsigned long)powerLimited, (unsigned long)powerOutputs);
+  powerOutputs = 0;
+  powerLimited = 0;
+  powerSumMa = 0;
+  powerMaxMa = 0;
+  
+#ifdef FASTLED_DEBUG_COUNT_FRAME_RETRIES
+  // Strip 1 frames FastLED had to restart because an interrupt ran too long
+  LOG_INFO("Strip 1: %lu retries in %lu frames", (unsigned long)_retry_cnt, (unsigned long)_frame_cnt);
+  _retry_cnt = 0;
+  _frame_cnt = 0;
+#endif
 }
 
 void LEDController::setMode(uint8_t mode) {
   if (mode < config->numModes) {
-    // Disable interrupts during mode change to prevent race conditions
-    noInterrupts();
-    
     currentMode = mode;
-    effectStep = 0; // Reset effect animation
     
-    // Clear LEDs when changing mode
-    fill_solid(leds1, NUM_LEDS_PER_STRIP, CRGB::Black);
-    fill_solid(leds2, NUM_LEDS_PER_STRIP, CRGB::Black);
-    FastLED.show();
+    if (EFFECT_LAYERS > 1 && transitionsEnabled && layers[front].effects.activeType() != NUM_EFFECTS) {
+      // Crossfade: the old mode keeps running on its layer while the new one
+      // comes up on the other (a fade still in progress loses its old mode)
+      front = (front + 1) % EFFECT_LAYERS;
+      transitionActive = true;
+      transitionStart = millis();
+      transitionFrames = 0;
+      transitionCostSum = 0;
+      transitionCostMax = 0;
+    } else if (layers[front].effects.activeType() != NUM_EFFECTS) {
+      // Hard cut, clear LEDs when changing mode (at boot there's nothing
+      // to clear, the first frame comes next)
+      fill(CRGB::Black);
+      show();
+    }
     
-    // Re-enable interrupts
-    interrupts();
+    // Tear down the layer's old effect and build the new one (also resets its animation)
+    EffectLayer& layer = layers[front];
+    fill_solid(&layer.strips[0][0], TOTAL_LEDS, CRGB::Black);
+    fill_solid(layer.line, STAFF_LINE_LEDS, CRGB::Black);
+    layer.effects.activate(mode);
+    povSpinning = false;
+    povColumn = -1;
     
-    Serial.print("Mode changed to: ");
-    Serial.println(currentMode);
+    LOG_DEBUG("Effect for mode %u activated", currentMode);
+  }
+}
+
+/**
+ * Set how much work the effects may do per frame and whether mode changes
+ * crossfade; a fade already running finishes
+ */
+void LEDController::setQuality(uint8_t detail, bool transitions) {
+  for (uint8_t l = 0; l < EFFECT_LAYERS; l++) {
+    layers[l].effects.setDetail(detail);
+  }
+  transitionsEnabled = transitions;
+}
+
+/**
+ * Save or restore the animation state of the effect on show, one instance
+ * per strip (line effects only have the first), see Effect::saveState()
+ */
+uint16_t LEDController::saveEffectState(uint8_t strip, uint8_t* state, uint16_t room) const {
+  Effect* effect = layers[front].effects.instance(strip);
+  return effect ? effect->saveState(state, room) : 0;
+}
+
+void LEDController::restoreEffectState(uint8_t strip, const uint8_t* state, uint16_t length) {
+  Effect* effect = layers[front].effects.instance(strip);
+  if (effect) {
+    effect->restoreState(state, length);
   }
 }
 
+/**
+ * Start the impact flash: a white overlay added to whatever the effect
+ * shows, held for half the flash duration and then faded out
+ */
 void LEDController::triggerImpactEffect() {
   // Disable interrupts during impact effect activation to prevent race conditions
   noInterrupts();
   
   impactEffectActive = true;
   impactEffectStart = millis();
+  frameDirty = true;
   
   // Re-enable interrupts
   interrupts();
+  
+  // The flash used to replace the frame with (25, 25, 25) at the impact
+  // brightness; this is the same light at the normal brightness
+  uint16_t level = normalBrightness ? 25 * config->impactBrightness / normalBrightness : 255;
+  if (level > 255) level = 255;
+  
+  uint16_t hold = config->impactFlashDuration / 2;
+  AlphaEnvelope envelope = { 0, hold, (uint16_t)(config->impactFlashDuration - hold) };
+  compositor.add(CRGB(level, level, level), BLEND_ADD, envelope, impactEffectStart);
 }
 
 void LEDController::setBrightness(uint8_t brightness) {
   normalBrightness = brightness;
-  
-  // Only set FastLED brightness directly if no impact effect is active
-  if (!impactEffectActive) {
-    FastLED.setBrightness(brightness);
-  }
-  
+  FastLED.setBrightness(brightness);
   config->brightness = brightness;
 }
 
 // Force a complete refresh of the LED strips
 void LEDController::forceRefresh() {
-  // Disable interrupts during refresh to prevent race conditions
-  noInterrupts();
-  
   // Clear both strips
-  fill_solid(leds1, NUM_LEDS_PER_STRIP, CRGB::Black);
-  fill_solid(leds2, NUM_LEDS_PER_STRIP, CRGB::Black);
-  FastLED.show();
-  
-  // Reset effect step counter
-  effectStep = 0;
+  fill(CRGB::Black);
+  show();
   
   // Ensure impactEffectActive is reset
   impactEffectActive = false;
+  compositor.clear();
   
   // Set brightness to correct value
   FastLED.setBrightness(normalBrightness);
   
-  // Re-enable interrupts
-  interrupts();
-  
-  Serial.println("LED strips forcefully refreshed");
+  LOG_INFO("LED strips forcefully refreshed");
 }
-
-// Effect implementation (note: most effects are now implemented in separate classes)
-void LEDController::updateSolidEffect() {
-  // Solid color effect - slowly changing hue
-  CRGB color = CHSV(effectStep/2, 255, 255);
-  
-  fill_solid(leds1, NUM_LEDS_PER_STRIP, color);
-  fill_solid(leds2, NUM_LEDS_PER_STRIP, color);
-}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Logger.h"
+#include <stdarg.h>
+
+Logger logger;
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+#define LOG_MASK (LOG_BUFFER_SIZE - 1)
+
+static_assert((LOG_BUFFER_SIZE & LOG_MASK) == 0, "LOG_BUFFER_SIZE must be a power of two");
+static_assert(LOG_BUFFER_SIZE <= 32768, "Ring indices are 16-bit");
+
+/**
+ * Format a line as "<millis> <level> <message>" and queue it
+ * A line that doesn't fit in the ring is dropped whole and counted
+ */
+void Logger::write(char level, const char* format, ...) {
+  char line[LOG_LINE_MAX];
+  int length = snprintf(line, sizeof(line), "%lu %c ", millis(), level);
+  
+  va_list args;
+  va_start(args, format);
+  int message = vsnprintf_P(line + length, sizeof(line) - length - 1, format, args);
+  va_end(args);
+  if (message < 0) {
+    return;
+  }
+  
+  // vsnprintf returns the untruncated length
+  length += min(message, (int)sizeof(line) - length - 2);
+  line[length++] = '\n';
+  
+  if (!push(line, length)) {
+    dropped++;
+  }
+}
+
+bool Logger::push(const char* text, uint16_t length) {
+  if (length > LOG_BUFFER_SIZE - (uint16_t)(head - tail)) {
+    return false;
+  }
+  
+  for (uint16_t i = 0; i < length; i++) {
+    ring[(head + i) & LOG_MASK] = text[i];
+  }
+  head += length;
+  return true;
+}
+
+void Logger::drain() {
+  if (dropped > 0) {
+    char note[40];
+    int length = snprintf(note, sizeof(note), "%lu W %lu log lines dropped\n", millis(), (unsigned long)dropped);
+    if (push(note, length)) {
+      dropped = 0;
+    }
+  }
+  
+  int room = Serial.availableForWrite();
+  while (room > 0 && head != tail) {
+    // Contiguous run up to the end of the ring
+    uint16_t start = tail & LOG_MASK;
+    uint16_t chunk = min<uint16_t>((uint16_t)(head - tail), LOG_BUFFER_SIZE - start);
+    if (chunk > room) {
+      chunk = room;
+    }
+    Serial.write((const uint8_t*)ring + start, chunk);
+    tail += chunk;
+    room -= chunk;
+  }
+}
+
+void Logger::flush() {
+  while (head != tail || dropped > 0) {
+    drain();
+    yield();
+  }
+  Serial.flush();
+}
+
+#endif // LOG_LEVEL
@@ -0,0 +1,67 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "version.h"
+
+// Deferred logging (LOG_LEVEL in version.h)
+// The LOG_* macros take a printf format and timestamp the line, since it
+// may go out a while after it was logged. Call from loop() context only,
+// not from interrupts. Setup, calibration and on-request dumps still
+// print to Serial directly, after flush().
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+class Logger {
+private:
+  char ring[LOG_BUFFER_SIZE];
+  uint16_t head;      // Free-running, masked on access
+  uint16_t tail;
+  uint32_t dropped;   // Lines lost to a full ring since the last note
+  
+  bool push(const char* text, uint16_t length);
+  
+public:
+  Logger() : head(0), tail(0), dropped(0) {}
+  
+  void write(char level, const char* format, ...);  // format in PROGMEM
+  void drain();  // Send what the UART FIFO has room for, never blocks
+  void flush();  // Send everything, blocking
+  bool empty() const { return head == tail && dropped == 0; }
+};
+
+#else
+
+// Logging compiled out - nothing to send
+class Logger {
+public:
+  void drain() {}
+  void flush() {}
+  bool empty() const { return true; }
+};
+
+#endif // LOG_LEVEL
+
+extern Logger logger;
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) logger.write('E', PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) logger.write('W', PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) logger.write('I', PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) logger.write('D', PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while (0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,6 @@
+// Fixed palette tables, computed by the compiler and kept in flash
+
+#include "Effects/Palette.h"
+
+constexpr PaletteTable HEAT_PALETTE_TABLE PROGMEM = buildPaletteTable<heatEntry>();
+constexpr PaletteTable HUE_PALETTE_TABLE PROGMEM = buildPaletteTable<hueEntry>();
@@ -0,0 +1,126 @@
+#ifndef POWER_LIMITER_H
+#define POWER_LIMITER_H
+
+#include <FastLED.h>
+
+// WS2812B current per channel at full on and per LED when dark, in mA
+// (the figures FastLED's power management uses)
+#define LED_MA_RED 16
+#define LED_MA_GREEN 11
+#define LED_MA_BLUE 15
+#define LED_MA_IDLE 1
+
+// Per-channel sums of a frame's pixel values, accumulated by the steps
+// that compose the frame rather than in a pass of their own
+struct PowerEstimate {
+  uint32_t channel[3];  // r, g, b
+
+  PowerEstimate() { reset(); }
+
+  // An all-black frame
+  void reset() {
+    channel[0] = channel[1] = channel[2] = 0;
+  }
+
+  void add(const CRGB& c) {
+    channel[0] += c.r;
+    channel[1] += c.g;
+    channel[2] += c.b;
+  }
+
+  // count pixels of one color
+  void add(const CRGB& c, uint16_t count) {
+    channel[0] += (uint32_t)c.r * count;
+    channel[1] += (uint32_t)c.g * count;
+    channel[2] += (uint32_t)c.b * count;
+  }
+
+  // Current drawn by ledCount LEDs showing the frame at a global brightness
+  uint32_t milliamps(uint8_t brightness, uint16_t ledCount) const {
+    uint32_t weighted = channel[0] * LED_MA_RED + channel[1] * LED_MA_GREEN + channel[2] * LED_MA_BLUE;
+    return (uint32_t)(((uint64_t)weighted * brightness) / (255 * 256)) + (uint32_t)ledCount * LED_MA_IDLE;
+  }
+};
+
+// Sums channel bytes read a 32-bit word at a time, for word-wise pixel
+// kernels. Pixels are 3 bytes, so byte j of the w-th (little-endian) word
+// is channel (w + j) % 3; the even and odd bytes are summed in two 16-bit
+// lanes per phase and moved into the estimate before a lane could overflow.
+class WordChannelSums {
+private:
+  PowerEstimate& power;
+  uint32_t even[3];  // Bytes 0 and 2 of words at each phase
+  uint32_t odd[3];   // Bytes 1 and 3
+  uint8_t phase;
+  uint16_t pending;  // Words since the last flush
+
+public:
+  // Words must start on a pixel boundary
+  explicit WordChannelSums(PowerEstimate& estimate) : power(estimate), even{0, 0, 0}, odd{0, 0, 0},
+                                                      phase(0), pending(0) {}
+  ~WordChannelSums() { flush(); }
+
+  void add(uint32_t word) {
+    even[phase] += word & 0x00FF00FF;
+    odd[phase] += (word >> 8) & 0x00FF00FF;
+    phase = (phase == 2) ? 0 : phase + 1;
+    // Each lane takes a third of the words, 256 x 255 fits in 16 bits
+    if (++pending == 768) {
+      flush();
+    }
+  }
+
+  void flush() {
+    for (uint8_t p = 0; p < 3; p++) {
+      power.channel[p] += (even[p] & 0xFFFF) + (odd[p] >> 16);
+      power.channel[(p + 1) % 3] += odd[p] & 0xFFFF;
+      power.channel[(p + 2) % 3] += even[p] >> 16;
+      even[p] = odd[p] = 0;
+    }
+    pending = 0;
+  }
+};
+
+// Copy count pixels, summing them into the estimate on the way
+// Word-wise when both buffers are 4-byte aligned, like crossfadePixels()
+inline void copyPixels(const CRGB* src, CRGB* out, uint16_t count, PowerEstimate& power) {
+  const uint8_t* a = src->raw;
+  uint8_t* o = out->raw;
+  size_t bytes = (size_t)count * 3;
+  size_t i = 0;
+
+  if ((((uintptr_t)a | (uintptr_t)o) & 3) == 0) {
+    const uint32_t* wa = reinterpret_cast<const uint32_t*>(a);
+    uint32_t* wo = reinterpret_cast<uint32_t*>(o);
+    WordChannelSums sums(power);
+    size_t words = bytes / 4;
+    for (size_t w = 0; w < words; w++) {
+      uint32_t x = wa[w];
+      wo[w] = x;
+      sums.add(x);
+    }
+    i = words * 4;
+  }
+
+  for (; i < bytes; i++) {
+    o[i] = a[i];
+    power.channel[i % 3] += a[i];
+  }
+}
+
+// Highest brightness up to requested that keeps ledCount LEDs showing the
+// estimated frame within budgetMa
+inline uint8_t limitBrightness(const PowerEstimate& power, uint8_t requested, uint16_t ledCount, uint32_t budgetMa) {
+  uint32_t idle = (uint32_t)ledCount * LED_MA_IDLE;
+  if (power.milliamps(requested, ledCount) <= budgetMa) {
+    return requested;
+  }
+  if (budgetMa <= idle) {
+    return 0;
+  }
+  uint32_t full = power.milliamps(255, ledCount) - idle;  // Pixel current at brightness 255
+  uint32_t limited = (uint64_t)(budgetMa - idle) * 255 / full;
+  return limited < requested ? limited : requested;
+}
+
+#endif // POWER_LIMITER_H
@@ -0,0 +1,93 @@
+#include "BoStaff.h"
+extern "C" {
+#include <user_interface.h>
+}
+
+// The firmware has no networking: skip RF calibration at reset and leave
+// the radio unpowered (saves the ~70 mA the modem draws while it's on)
+RF_MODE(RF_DISABLED);
+
+#if IDLE_SLEEP
+
+static volatile bool wakeTimerFired = false;
+
+// CCOMPARE0 matched: the deadline has come. Moving the compare to just
+// behind the cycle counter clears the interrupt until the next sleep
+// arms it (or ~53 s from now, a harmless spare wake).
+static void IRAM_ATTR onWakeTimer() {
+  timer0_write(ESP.getCycleCount() - 1);
+  wakeTimerFired = true;
+}
+
+// Only there to end a sleep, ButtonHandler still reads the pin
+static void IRAM_ATTR onButtonEdge() {
+}
+
+#endif
+
+void PowerState::begin() {
+  // Belt and braces with RF_MODE: no station or AP, modem forced to sleep
+  wifi_set_opmode_current(NULL_MODE);
+  wifi_fpm_set_sleep_type(MODEM_SLEEP_T);
+  wifi_fpm_open();
+  wifi_fpm_do_sleep(0xFFFFFFF);
+  
+#if IDLE_SLEEP
+  timer0_isr_init();
+  timer0_attachInterrupt(onWakeTimer);
+  attachInterrupt(digitalPinToInterrupt(BTN_PIN), onButtonEdge, CHANGE);
+#endif
+  
+  windowStart = micros();
+  Serial.println(F("Radio off, idle sleep between frames"));
+}
+
+/**
+ * Halt the CPU until deadlineMicros or an interrupt, whichever is first
+ * Interrupts are masked while the wake timer is armed, so one that fires
+ * in between is taken by waiti itself rather than missed. Timers and the
+ * UARTs keep running; only the CPU core stops.
+ */
+void PowerState::sleepUntil(unsigned long deadlineMicros) {
+#if IDLE_SLEEP
+  unsigned long start = micros();
+  long remaining = (long)(deadlineMicros - start);
+  if (remaining < IDLE_MIN_SLEEP_US) {
+    return;
+  }
+  
+  uint32_t savedPs = xt_rsil(15);
+  wakeTimerFired = false;
+  timer0_write(ESP.getCycleCount() + (uint32_t)remaining * clockCyclesPerMicrosecond());
+  __asm__ __volatile__("waiti 0" ::: "memory");
+  xt_wsr_ps(savedPs);
+  
+  sleptMicros += micros() - start;
+  sleeps++;
+  if (!wakeTimerFired) {
+    earlyWakes++;
+  }
+#endif
+}
+
+/**
+ * Print the share of time the CPU was awake since the last call and start over
+ */
+void PowerState::printStats() {
+  unsigned long now = micros();
+  unsigned long window = now - windowStart;
+  if (window == 0) {
+    return;
+  }
+  
+  // Awake share to a tenth of a percent, without float formatting
+  uint32_t awakePermille = 1000 - (uint32_t)((uint64_t)sleptMicros * 1000 / window);
+  LOG_INFO("CPU awake: %lu.%lu%%, %lu sleeps, %lu woken early",
+           (unsigned long)(awakePermille / 10), (unsigned long)(awakePermille % 10),
+           (unsigned long)sleeps, (unsigned long)earlyWakes);
+  
+  windowStart = now;
+  sleptMicros = 0;
+  sleeps = 0;
+  earlyWakes = 0;
+}
@@ -0,0 +1,106 @@
+#include "BoStaff.h"
+
+#if PROFILER_ENABLED
+
+#define STAGE_SHIFT 28
+#define DURATION_MASK ((1UL << STAGE_SHIFT) - 1)
+
+Profiler profiler;
+
+static const char* const STAGE_NAMES[PROFILE_STAGES] = {
+  "accel", "effects", "show", "pov", "button", "power"
+};
+
+/**
+ * Mark the start of a loop() pass; the time since the previous one is the
+ * loop total that busy and idle shares are taken from
+ */
+void Profiler::loopStart() {
+  uint32_t now = ESP.getCycleCount();
+  if (lastLoopStart != 0) {
+    loopCycles += now - lastLoopStart;
+  }
+  lastLoopStart = now;
+  loops++;
+}
+
+void Profiler::record(ProfileStage stage, uint32_t start, uint32_t end) {
+  uint32_t duration = end - start;
+  
+  if (stage == PROFILE_IDLE) {
+    idleCycles += duration;
+    return;
+  }
+  
+  runs[stage]++;
+  cycles[stage] += duration;
+  if (duration > maxCycles[stage]) {
+    maxCycles[stage] = duration;
+  }
+  
+  Event& event = ring[ringHead];
+  event.start = start;
+  event.packed = ((uint32_t)stage << STAGE_SHIFT) | (duration < DURATION_MASK ? duration : DURATION_MASK);
+  ringHead = (ringHead + 1) % PROFILER_RING_SIZE;
+  if (ringCount < PROFILER_RING_SIZE) {
+    ringCount++;
+  }
+}
+
+void Profiler::resetSummary() {
+  memset(runs, 0, sizeof(runs));
+  memset(cycles, 0, sizeof(cycles));
+  memset(maxCycles, 0, sizeof(maxCycles));
+  idleCycles = 0;
+  loopCycles = 0;
+  loops = 0;
+}
+
+/**
+ * Print per-stage run counts, average and worst times and share of the
+ * loop since the last call, then start over
+ */
+void Profiler::printSummary() {
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  uint64_t total = loopCycles > 0 ? loopCycles : 1;
+  
+  Serial.print(F("Profile: ")); Serial.print(loops);
+  Serial.print(F(" loops, busy ")); Serial.print(100.0f * (total - min(idleCycles, total)) / total, 1);
+  Serial.print(F("%, idle ")); Serial.print(100.0f * min(idleCycles, total) / total, 1);
+  Serial.println(F("%"));
+  
+  for (uint8_t s = 0; s < PROFILE_STAGES; s++) {
+    if (runs[s] == 0) continue;
+    Serial.print(F("  ")); Serial.print(STAGE_NAMES[s]);
+    Serial.print(F(": ")); Serial.print(runs[s]);
+    Serial.print(F(" runs, avg ")); Serial.print((unsigned long)(cycles[s] / runs[s] / mhz));
+    Serial.print(F(" us, max ")); Serial.print(maxCycles[s] / mhz);
+    Serial.print(F(" us, ")); Serial.print(100.0f * cycles[s] / total, 1);
+    Serial.println(F("%"));
+  }
+  
+  resetSummary();
+}
+
+/**
+ * Stream the ring as Chrome trace events, times in microseconds from the
+ * oldest event (the cycle counter wraps every 53 s at 80 MHz, far longer
+ * than the ring spans)
+ */
+void Profiler::dumpTrace() {
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  uint16_t first = (ringHead + PROFILER_RING_SIZE - ringCount) % PROFILER_RING_SIZE;
+  uint32_t origin = ring[first].start;
+  
+  Serial.println(F("{\"traceEvents\":["));
+  for (uint16_t i = 0; i < ringCount; i++) {
+    const Event& event = ring[(first + i) % PROFILER_RING_SIZE];
+    Serial.print(F("{\"name\":\"")); Serial.print(STAGE_NAMES[event.packed >> STAGE_SHIFT]);
+    Serial.print(F("\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":")); Serial.print((event.start - origin) / mhz);
+    Serial.print(F(",\"dur\":")); Serial.print((event.packed & DURATION_MASK) / mhz);
+    Serial.println(i + 1 < ringCount ? F("},") : F("}"));
+  }
+  Serial.println(F("]}"));
+}
+
+#endif // PROFILER_ENABLED
@@ -0,0 +1,132 @@
+#include "BoStaff.h"
+
+// The levels, best first. Crossfades run two effects at once, so they go
+// as soon as the sensor rate does.
+static const QualityProfile QUALITY_PROFILES[QUALITY_LEVELS] = {
+  { "full",    FRAME_MIN_INTERVAL_US, 255, MPU_SAMPLE_RATE_HZ,     true },
+  { "reduced", 20000,                 192, MPU_SAMPLE_RATE_HZ,     true },
+  { "eco",     33333,                 128, MPU_SAMPLE_RATE_HZ / 2, false },
+  { "minimal", FRAME_MAX_INTERVAL_US, 64,  MPU_SAMPLE_RATE_HZ / 4, false },
+};
+
+// Voltage below which each level after the first is the best allowed
+static const float BATTERY_THRESHOLDS[QUALITY_LEVELS - 1] = {
+  GOVERNOR_BATTERY_REDUCED,
+  GOVERNOR_BATTERY_ECO,
+  GOVERNOR_BATTERY_MINIMAL,
+};
+
+void QualityGovernor::begin(FrameClock* frameClock, LEDController* ledController, AccelerometerHandler* accelerometer) {
+  clock = frameClock;
+  leds = ledController;
+  accel = accelerometer;
+  lastCheck = millis();
+  levelSince = lastCheck;
+}
+
+/**
+ * Re-evaluate the quality level once per GOVERNOR_CHECK_MS
+ * The battery sets the best level allowed; on top of that the load level
+ * drops when frames keep costing more than the budget and climbs back
+ * after a longer stretch with headroom.
+ */
+void QualityGovernor::update(float batteryVoltage) {
+  unsigned long now = millis();
+  if (now - lastCheck < GOVERNOR_CHECK_MS) {
+    return;
+  }
+  lastCheck = now;
+  lastVoltage = batteryVoltage;
+
+  // Climbing back above a threshold takes the hysteresis margin
+  QualityLevel battery = QUALITY_FULL;
+  for (uint8_t i = 0; i < QUALITY_LEVELS - 1; i++) {
+    float threshold = BATTERY_THRESHOLDS[i];
+    if (i < batteryLevel) {
+      threshold += GOVERNOR_BATTERY_HYSTERESIS;
+    }
+    if (batteryVoltage < threshold) {
+      battery = (QualityLevel)(i + 1);
+    }
+  }
+  batteryLevel = battery;
+
+  unsigned long cost = clock->getFrameCost();
+  if (cost > GOVERNOR_FRAME_BUDGET_US) {
+    underBudget = 0;
+    if (++overBudget >= GOVERNOR_DOWN_CHECKS) {
+      overBudget = 0;
+      if (loadLevel < QUALITY_LEVELS - 1) {
+        loadLevel = (QualityLevel)(loadLevel + 1);
+      }
+    }
+  } else if (cost * 100 < (unsigned long)GOVERNOR_FRAME_BUDGET_US * GOVERNOR_HEADROOM_PCT) {
+    overBudget = 0;
+    if (++underBudget >= GOVERNOR_UP_CHECKS) {
+      underBudget = 0;
+      if (loadLevel > QUALITY_FULL) {
+        loadLevel = (QualityLevel)(loadLevel - 1);
+      }
+    }
+  } else {
+    overBudget = 0;
+    underBudget = 0;
+  }
+
+  if (batteryLevel >= loadLevel) {
+    apply(batteryLevel, "battery");
+  } else {
+    apply(loadLevel, "frame time");
+  }
+}
+
+/**
+ * Switch to a level and hand its settings to the frame clock, the effects
+ * and the accelerometer
+ */
+void QualityGovernor::apply(QualityLevel newLevel, const char* reason) {
+  if (newLevel == level) {
+    return;
+  }
+
+  unsigned long now = millis();
+  levelMillis[level] += now - levelSince;
+  levelSince = now;
+  changes++;
+
+  const QualityProfile& profile = QUALITY_PROFILES[newLevel];
+  LOG_INFO("Quality %s -> %s (%s: %lu us/frame, %d mV)", QUALITY_PROFILES[level].name, profile.name,
+           reason, clock->getFrameCost(), (int)(lastVoltage * 1000));
+  level = newLevel;
+
+  clock->setMinInterval(profile.frameIntervalUs);
+  leds->setQuality(profile.effectDetail, profile.transitions);
+  accel->setSampleRate(profile.sensorRateHz);
+}
+
+/**
+ * Print the current level, what it's based on and the time spent at each
+ */
+void QualityGovernor::print() {
+  const QualityProfile& profile = QUALITY_PROFILES[level];
+  Serial.print(F("Quality: ")); Serial.print(profile.name);
+  Serial.print(F(" (battery allows ")); Serial.print(QUALITY_PROFILES[batteryLevel].name);
+  Serial.print(F(" at ")); Serial.print(lastVoltage); Serial.print(F("V, frame time allows "));
+  Serial.print(QUALITY_PROFILES[loadLevel].name); Serial.println(F(")"));
+
+  Serial.print(F("  frame cost ")); Serial.print(clock->getFrameCost());
+  Serial.print(F(" us of ")); Serial.print(GOVERNOR_FRAME_BUDGET_US);
+  Serial.print(F(" us, interval ")); Serial.print(clock->getTargetInterval());
+  Serial.print(F(" us, detail ")); Serial.print(profile.effectDetail);
+  Serial.print(F(", sensor ")); Serial.print(accel->getSampleRate());
+  Serial.print(F(" Hz, crossfades ")); Serial.println(profile.transitions ? F("on") : F("off"));
+
+  unsigned long now = millis();
+  Serial.print(F("  time at level:"));
+  for (uint8_t i = 0; i < QUALITY_LEVELS; i++) {
+    uint32_t spent = levelMillis[i] + (i == level ? now - levelSince : 0);
+    Serial.print(' '); Serial.print(QUALITY_PROFILES[i].name);
+    Serial.print(' '); Serial.print(spent / 1000); Serial.print('s');
+  }
+  Serial.print(F(", changes: ")); Serial.println(changes);
+}
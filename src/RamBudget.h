@@ -0,0 +1,58 @@
+#ifndef RAM_BUDGET_H
+#define RAM_BUDGET_H
+
+#include <Arduino.h>
+#include "version.h"
+#include "effects.h"
+#include "Ws2812Encoder.h"
+
+// Statically allocated RAM for frames, effect state and diagnostics,
+// checked against RAM_BUDGET_BYTES when the firmware is compiled.
+// Everything here is fixed at build time, so the heap only serves the
+// SDK and libraries and can't fragment over a long show.
+
+constexpr size_t RAM_LED_BUFFERS = sizeof(CRGB) * 2 * STAFF_STRIP_LEDS;  // Both strips as sent
+constexpr size_t RAM_EFFECT_LAYERS = EFFECT_LAYERS * sizeof(CRGB) * (2 * STAFF_STRIP_LEDS + STAFF_LINE_LEDS);  // Render targets, two while crossfading
+constexpr size_t RAM_ASYNC_OUTPUT = LED_OUTPUT_ASYNC ? 2 * STAFF_STRIP_LEDS * WS2812_UART_BYTES_PER_PIXEL : 0;
+constexpr size_t RAM_EFFECT_ARENA = EFFECT_LAYERS * 2 * EFFECT_SLOT_SIZE;  // One slot per strip and layer
+constexpr size_t RAM_GEOMETRY = 2 * sizeof(StaffGeometry);  // Folded and line tables; .rodata is in RAM on the ESP8266
+constexpr size_t RAM_LOG_RING = LOG_LEVEL > LOG_LEVEL_NONE ? LOG_BUFFER_SIZE : 0;
+constexpr size_t RAM_PROFILER_RING = PROFILER_ENABLED ? PROFILER_RING_SIZE * 8 : 0;
+
+constexpr size_t RAM_STATIC_TOTAL = RAM_LED_BUFFERS + RAM_EFFECT_LAYERS + RAM_ASYNC_OUTPUT + RAM_EFFECT_ARENA +
+                                    RAM_GEOMETRY + RAM_LOG_RING + RAM_PROFILER_RING;
+
+static_assert(RAM_STATIC_TOTAL <= RAM_BUDGET_BYTES,
+              "Frame buffers and effect state exceed RAM_BUDGET_BYTES (version.h) - see printRamBudget()");
+
+inline void printRamBudgetLine(const char* name, size_t bytes) {
+  Serial.print(name); Serial.print((unsigned long)bytes); Serial.println(" B");
+}
+
+// Breakdown of the static RAM budget, printed at boot and by the host bench
+// One line per call so the boot banner can spread it over loop() passes
+#define RAM_BUDGET_LINES 8
+
+inline void printRamBudget(uint8_t line) {
+  switch (line) {
+    case 0: printRamBudgetLine("  LED buffers:      ", RAM_LED_BUFFERS); break;
+    case 1: printRamBudgetLine("  Effect layers:    ", RAM_EFFECT_LAYERS); break;
+    case 2: printRamBudgetLine("  Async output:     ", RAM_ASYNC_OUTPUT); break;
+    case 3: printRamBudgetLine("  Effect arena:     ", RAM_EFFECT_ARENA); break;
+    case 4: printRamBudgetLine("  Geometry tables:  ", RAM_GEOMETRY); break;
+    case 5: printRamBudgetLine("  Log ring:         ", RAM_LOG_RING); break;
+    case 6: printRamBudgetLine("  Profiler ring:    ", RAM_PROFILER_RING); break;
+    case 7:
+      Serial.print("  Total: "); Serial.print((unsigned long)RAM_STATIC_TOTAL);
+      Serial.print(" of "); Serial.print((unsigned long)RAM_BUDGET_BYTES); Serial.println(" B budget");
+      break;
+  }
+}
+
+inline void printRamBudget() {
+  for (uint8_t line = 0; line < RAM_BUDGET_LINES; line++) {
+    printRamBudget(line);
+  }
+}
+
+#endif // RAM_BUDGET_H
@@ -1,42 +1,96 @@
 #include "BoStaff.h"
 #include <EEPROM.h>
+#include <LittleFS.h>
 #include "../src/version.h" // Include version.h for constants
+#include "Crc32.h"
 
-// EEPROM size for ESP8266
-#define EEPROM_SIZE 512
+// Settings are journaled on LittleFS instead of rewriting the EEPROM sector
+// on every change. Each save appends a fixed-size, CRC-checked record with a
+// sequence number and loading takes the newest record that checks out, so a
+// torn write only loses that one save. The journal alternates between two
+// files: when one is full the next record starts the other and the full one
+// is removed. Saves are write-behind - see update().
+#define SETTINGS_JOURNAL_RECORDS 64   // Per file before switching
+#define SETTINGS_RECORD_MAGIC 0xB05F
+#define SETTINGS_RECORD_VERSION 1
+#define SETTINGS_QUIET_MS 5000        // Write once the settings stopped changing for this long
 
-// Magic bytes to check if settings are valid
+// Pre-journal settings in the emulated EEPROM, read once to migrate them
+#define EEPROM_SIZE 512
 #define SETTINGS_MAGIC_BYTE_1 0xAB
 #define SETTINGS_MAGIC_BYTE_2 0xCD
 
+struct SettingsRecord {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t length;
+  uint32_t sequence;
+  uint8_t currentMode;
+  uint8_t brightness;
+  uint8_t impactBrightness;
+  uint8_t reserved;
+  uint16_t impactThreshold;
+  uint16_t impactFlashDuration;
+  uint32_t crc;  // CRC-32 of the bytes before it
+};
+
+static_assert(sizeof(SettingsRecord) == 20, "Settings records are stored as-is");
+
+static const char* const JOURNAL_FILES[2] = { "/settings.0", "/settings.1" };
+
+static bool validRecord(const SettingsRecord& record) {
+  return record.magic == SETTINGS_RECORD_MAGIC &&
+         record.version == SETTINGS_RECORD_VERSION &&
+         record.length == sizeof(SettingsRecord) &&
+         record.crc == recordCrc32(&record, offsetof(SettingsRecord, crc));
+}
+
+// Check that the last record of a journal file is the one just written
+static bool readBack(uint8_t target, const SettingsRecord& expected) {
+  File file = LittleFS.open(JOURNAL_FILES[target], "r");
+  if (!file) {
+    return false;
+  }
+  
+  SettingsRecord record;
+  bool ok = file.size() >= sizeof(record) &&
+            file.seek(file.size() - sizeof(record)) &&
+            file.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+  file.close();
+  return ok && validRecord(record) && memcmp(&record, &expected, sizeof(record)) == 0;
+}
+
+// The persisted fields - numModes is derived, not stored
+static bool sameSettings(const Config& a, const Config& b) {
+  return a.currentMode == b.currentMode &&
+         a.brightness == b.brightness &&
+         a.impactBrightness == b.impactBrightness &&
+         a.impactThreshold == b.impactThreshold &&
+         a.impactFlashDuration == b.impactFlashDuration;
+}
+
 void SettingsManager::begin() {
-  // Initialize EEPROM
-  EEPROM.begin(EEPROM_SIZE);
+  // Formats the partition on first use
+  fsReady = LittleFS.begin();
+  if (!fsReady) {
+    Serial.println("LittleFS mount failed - settings will not be saved");
+  }
   Serial.println("Settings Manager initialized");
 }
 
 bool SettingsManager::loadSettings(Config* cfg) {
-  // Read magic bytes to check if stored settings are valid
-  byte magic1 = EEPROM.read(configAddress);
-  byte magic2 = EEPROM.read(configAddress + 1);
+  config = cfg;
   
-  if (magic1 == SETTINGS_MAGIC_BYTE_1 && magic2 == SETTINGS_MAGIC_BYTE_2) {
-    // Read the stored settings
-    int addr = configAddress + 2; // Skip magic bytes
-    
-    cfg->currentMode = EEPROM.read(addr++); 
-    cfg->brightness = EEPROM.read(addr++); 
-    cfg->impactBrightness = EEPROM.read(addr++); // Added impact brightness
-    
-    // Read 16-bit values
-    byte lowByte = EEPROM.read(addr++);
-    byte highByte = EEPROM.read(addr++);
-    cfg->impactThreshold = lowByte | (highByte << 8);
-    
-    lowByte = EEPROM.read(addr++);
-    highByte = EEPROM.read(addr++);
-    cfg->impactFlashDuration = lowByte | (highByte << 8);
-    
+  bool loaded = loadJournal(cfg);
+  if (loaded) {
+    Serial.print("Settings loaded from journal, record "); Serial.println(sequence);
+  } else if (loadLegacy(cfg)) {
+    // Carry the old EEPROM settings over into the journal
+    loaded = true;
+    Serial.println("Settings migrated from EEPROM");
+  }
+  
+  if (loaded) {
     // Validate settings
     if (cfg->currentMode >= cfg->numModes) {
       cfg->currentMode = EFFECT_FIRE; // Default if invalid
@@ -49,35 +103,194 @@ bool SettingsManager::loadSettings(Config* cfg) {
     if (cfg->impactBrightness == 0) {
       cfg->impactBrightness = 25; // Reduced from 100 to 25 (10% of max 255)
     }
-    
-    Serial.println("Settings loaded from EEPROM");
-    return true;
   } else {
     // No valid settings found, use defaults
     Serial.println("No valid settings found, using defaults");
-    saveSettings(cfg); // Save defaults for next boot
+  }
+  
+  // Migrated or default settings are written right away
+  if (!loaded || journalRecords == 0) {
+    writeRecord(cfg);
+  }
+  return loaded;
+}
+
+/**
+ * Take over settings restored after a sleep, which were flushed to the
+ * journal before sleeping. The journal is still read for where the next
+ * record goes, but cfg is left alone.
+ */
+void SettingsManager::resume(Config* cfg) {
+  config = cfg;
+  Config journaled;
+  if (!loadJournal(&journaled)) {
+    written = Config();  // Anything saved later gets written
+  }
+}
+
+/**
+ * Find the newest valid record across both journal files
+ */
+bool SettingsManager::loadJournal(Config* cfg) {
+  if (!fsReady) {
+    return false;
+  }
+  
+  SettingsRecord newest;
+  bool found = false;
+  uint16_t records[2] = {0, 0};
+  bool misaligned[2] = {false, false};
+  
+  for (uint8_t f = 0; f < 2; f++) {
+    File file = LittleFS.open(JOURNAL_FILES[f], "r");
+    if (!file) {
+      continue;
+    }
+    misaligned[f] = (file.size() % sizeof(SettingsRecord)) != 0;
+    
+    SettingsRecord record;
+    while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+      records[f]++;
+      if (validRecord(record) && (!found || (int32_t)(record.sequence - newest.sequence) > 0)) {
+        newest = record;
+        journalFile = f;
+        found = true;
+      }
+    }
+    file.close();
+  }
+  
+  if (!found) {
     return false;
   }
+  
+  // Appending after a partial record would misalign everything after it,
+  // so start the other file with the next save
+  journalRecords = misaligned[journalFile] ? SETTINGS_JOURNAL_RECORDS : records[journalFile];
+  sequence = newest.sequence;
+  
+  cfg->currentMode = newest.currentMode;
+  cfg->brightness = newest.brightness;
+  cfg->impactBrightness = newest.impactBrightness;
+  cfg->impactThreshold = newest.impactThreshold;
+  cfg->impactFlashDuration = newest.impactFlashDuration;
+  written = *cfg;
+  return true;
 }
 
+/**
+ * Read settings saved by firmware from before the journal
+ */
+bool SettingsManager::loadLegacy(Config* cfg) {
+  EEPROM.begin(EEPROM_SIZE);
+  
+  // Read magic bytes to check if stored settings are valid
+  bool valid = EEPROM.read(0) == SETTINGS_MAGIC_BYTE_1 && EEPROM.read(1) == SETTINGS_MAGIC_BYTE_2;
+  if (valid) {
+    int addr = 2; // Skip magic bytes
+    
+    cfg->currentMode = EEPROM.read(addr++);
+    cfg->brightness = EEPROM.read(addr++);
+    cfg->impactBrightness = EEPROM.read(addr++);
+    
+    // Read 16-bit values
+    byte lowByte = EEPROM.read(addr++);
+    byte highByte = EEPROM.read(addr++);
+    cfg->impactThreshold = lowByte | (highByte << 8);
+    
+    lowByte = EEPROM.read(addr++);
+    highByte = EEPROM.read(addr++);
+    cfg->impactFlashDuration = lowByte | (highByte << 8);
+  }
+  
+  // Frees the RAM copy of the sector, nothing was changed
+  EEPROM.end();
+  return valid;
+}
+
+/**
+ * Schedule a save - it is written once the settings have been left alone
+ * for SETTINGS_QUIET_MS, so clicking through the modes costs one write
+ */
 void SettingsManager::saveSettings(Config* cfg) {
-  // Write magic bytes
-  EEPROM.write(configAddress, SETTINGS_MAGIC_BYTE_1);
-  EEPROM.write(configAddress + 1, SETTINGS_MAGIC_BYTE_2);
-  
-  // Write the settings
-  int addr = configAddress + 2; // Skip magic bytes
-  
-  EEPROM.write(addr++, cfg->currentMode);
-  EEPROM.write(addr++, cfg->brightness);
-  EEPROM.write(addr++, cfg->impactBrightness); // Added impact brightness
-  EEPROM.write(addr++, cfg->impactThreshold & 0xFF); 
-  EEPROM.write(addr++, (cfg->impactThreshold >> 8) & 0xFF);
-  EEPROM.write(addr++, cfg->impactFlashDuration & 0xFF);
-  EEPROM.write(addr++, (cfg->impactFlashDuration >> 8) & 0xFF);
-  
-  // Commit the changes
-  EEPROM.commit();
-  
-  Serial.println("Settings saved to EEPROM");
-}
\ No newline at end of file
+  config = cfg;
+  dirty = true;
+  lastChange = millis();
+}
+
+void SettingsManager::update() {
+  if (dirty && millis() - lastChange >= SETTINGS_QUIET_MS) {
+    flush();
+  }
+}
+
+/**
+ * Write a pending save now (before sleeping, after calibration)
+ */
+void SettingsManager::flush() {
+  if (!dirty) {
+    return;
+  }
+  dirty = false;
+  
+  // Clicking all the way round to the same mode needs no write
+  if (sameSettings(*config, written)) {
+    LOG_DEBUG("Settings unchanged, nothing to save");
+    return;
+  }
+  writeRecord(config);
+}
+
+/**
+ * Append one record to the journal, switching files when it is full
+ * The record counts as saved only once it reads back intact; until then
+ * the settings stay different from what was written, so the next save
+ * tries again.
+ */
+bool SettingsManager::writeRecord(const Config* cfg) {
+  if (!fsReady) {
+    return false;
+  }
+  
+  SettingsRecord record;
+  record.magic = SETTINGS_RECORD_MAGIC;
+  record.version = SETTINGS_RECORD_VERSION;
+  record.length = sizeof(SettingsRecord);
+  record.sequence = sequence + 1;
+  record.currentMode = cfg->currentMode;
+  record.brightness = cfg->brightness;
+  record.impactBrightness = cfg->impactBrightness;
+  record.reserved = 0;
+  record.impactThreshold = cfg->impactThreshold;
+  record.impactFlashDuration = cfg->impactFlashDuration;
+  record.crc = recordCrc32(&record, offsetof(SettingsRecord, crc));
+  
+  bool rotate = journalRecords >= SETTINGS_JOURNAL_RECORDS;
+  uint8_t target = rotate ? journalFile ^ 1 : journalFile;
+  
+  File file = LittleFS.open(JOURNAL_FILES[target], rotate ? "w" : "a");
+  bool ok = file && file.write((const uint8_t*)&record, sizeof(record)) == sizeof(record);
+  if (file) {
+    file.close();
+  }
+  if (ok) {
+    ok = readBack(target, record);
+  }
+  if (!ok) {
+    LOG_ERROR("Settings write failed");
+    return false;
+  }
+  
+  if (rotate) {
+    // The new file holds the latest settings, the old one can go
+    LittleFS.remove(JOURNAL_FILES[journalFile]);
+    journalFile = target;
+    journalRecords = 0;
+  }
+  journalRecords++;
+  sequence = record.sequence;
+  written = *cfg;
+  
+  LOG_INFO("Settings saved, record %lu", (unsigned long)sequence);
+  return true;
+}
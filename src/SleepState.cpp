@@ -0,0 +1,134 @@
+#include "BoStaff.h"
+#include "Crc32.h"
+
+#define SLEEP_RECORD_MAGIC 0xB05F51EE
+
+// Room per strip for the effect's animation state, enough for the fire's
+// heat map of a whole strip
+#define SLEEP_EFFECT_STATE_BYTES STAFF_STRIP_LEDS
+
+// Kept in RTC user memory across deep sleep (offset 0, 4-byte blocks)
+struct SleepRecord {
+  uint32_t magic;
+  uint32_t checks;  // Wake checks so far that found no motion
+  uint8_t currentMode;
+  uint8_t brightness;
+  uint8_t impactBrightness;
+  uint8_t reserved;
+  uint16_t impactThreshold;
+  uint16_t impactFlashDuration;
+  int32_t gyroBiasQ8;
+  uint16_t effectStateLength[NUM_STRIPS];  // Bytes used, see Effect::saveState()
+  uint8_t effectState[NUM_STRIPS][SLEEP_EFFECT_STATE_BYTES];
+  uint32_t crc;  // Of the bytes before it
+};
+
+static_assert(sizeof(SleepRecord) % 4 == 0, "RTC memory is written in 4-byte blocks");
+static_assert(sizeof(SleepRecord) <= 512, "RTC user memory holds 512 bytes");
+
+static uint32_t recordCrc(const SleepRecord& record) {
+  return recordCrc32(&record, offsetof(SleepRecord, crc));
+}
+
+static void writeRecord(SleepRecord& record) {
+  record.crc = recordCrc(record);
+  ESP.rtcUserMemoryWrite(0, (uint32_t*)&record, sizeof(record));
+}
+
+/**
+ * Decide how this boot goes, before anything else is started
+ * After a sleep check wake with no motion this goes back to sleep and
+ * never returns, so those wakes stay a few milliseconds long. Returns true
+ * when the board woke from sleep because it was moved or reset: config
+ * then holds the settings from before the sleep.
+ */
+bool SleepState::begin(Config* cfg, AccelerometerHandler* accelerometer, LEDController* ledController) {
+  config = cfg;
+  accel = accelerometer;
+  leds = ledController;
+  
+  // Only a deep sleep wake can be a timer check. An external reset (the
+  // reset button, esptool after flashing, or the motion one-shot if the
+  // core reports it that way) always wakes the staff, resuming if the
+  // record is there.
+  uint32_t reason = ESP.getResetInfoPtr()->reason;
+  if (reason != REASON_DEEP_SLEEP_AWAKE && reason != REASON_EXT_SYS_RST) {
+    return false;
+  }
+  
+  SleepRecord record;
+  if (!ESP.rtcUserMemoryRead(0, (uint32_t*)&record, sizeof(record)) ||
+      record.magic != SLEEP_RECORD_MAGIC || record.crc != recordCrc(record)) {
+    return false;
+  }
+  
+  if (reason == REASON_DEEP_SLEEP_AWAKE && !accel->motionLatched()) {
+    record.checks++;
+    writeRecord(record);
+    ESP.deepSleep((uint64_t)SLEEP_WAKE_CHECK_MS * 1000, RF_DISABLED);
+  }
+  
+  cfg->currentMode = record.currentMode < cfg->numModes ? record.currentMode : (uint8_t)EFFECT_FIRE;
+  cfg->brightness = record.brightness;
+  cfg->impactBrightness = record.impactBrightness;
+  cfg->impactThreshold = record.impactThreshold;
+  cfg->impactFlashDuration = record.impactFlashDuration;
+  checks = record.checks;
+  gyroBias = record.gyroBiasQ8;
+  
+  // A later reset from the button shouldn't find it
+  record.magic = 0;
+  writeRecord(record);
+  
+  resumed = true;
+  return true;
+}
+
+/**
+ * Hand the saved animation state to the effect just activated for the
+ * resumed mode, before its first frame
+ */
+void SleepState::restoreEffects() {
+  if (!resumed) {
+    return;
+  }
+  
+  // begin() cleared the magic but left the rest, CRC included, in place
+  SleepRecord record;
+  if (!ESP.rtcUserMemoryRead(0, (uint32_t*)&record, sizeof(record)) || record.crc != recordCrc(record)) {
+    return;
+  }
+  for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+    if (record.effectStateLength[s] > 0 && record.effectStateLength[s] <= SLEEP_EFFECT_STATE_BYTES) {
+      leds->restoreEffectState(s, record.effectState[s], record.effectStateLength[s]);
+    }
+  }
+}
+
+/**
+ * Save the state to RTC memory, arm the MPU's motion detection and sleep
+ * Without a working MPU nothing could tell the board it was moved, so it
+ * sleeps until reset as before.
+ */
+void SleepState::enter() {
+  if (!accel->armMotionWake()) {
+    ESP.deepSleep(0, RF_DISABLED);
+  }
+  
+  SleepRecord record = {};
+  record.magic = SLEEP_RECORD_MAGIC;
+  record.checks = 0;
+  record.currentMode = config->currentMode;
+  record.brightness = config->brightness;
+  record.impactBrightness = config->impactBrightness;
+  record.reserved = 0;
+  record.impactThreshold = config->impactThreshold;
+  record.impactFlashDuration = config->impactFlashDuration;
+  record.gyroBiasQ8 = accel->getGyroBias();
+  for (uint8_t s = 0; s < NUM_STRIPS; s++) {
+    record.effectStateLength[s] = leds->saveEffectState(s, record.effectState[s], SLEEP_EFFECT_STATE_BYTES);
+  }
+  writeRecord(record);
+  
+  ESP.deepSleep((uint64_t)SLEEP_WAKE_CHECK_MS * 1000, RF_DISABLED);
+}
@@ -0,0 +1,53 @@
+#ifndef WS2812_ENCODER_H
+#define WS2812_ENCODER_H
+
+#include <FastLED.h>
+
+// WS2812 bit encoding for a UART transmitting at 3.2 Mbaud, 6N1, TX inverted
+//
+// A UART frame is 8 bit times of 312.5 ns: start, 6 data bits (LSB first),
+// stop. With the line inverted the start bit is high and the stop bit low,
+// so each frame is exactly two 1.25 us WS2812 bits, and every 3 data bits
+// pick a short (0) or long (1) high pulse. One color byte therefore takes
+// four UART bytes, and a pixel twelve. Pure functions, so they can be
+// checked and benchmarked on the host.
+
+#define WS2812_UART_BAUD 3200000
+#define WS2812_UART_BYTES_PER_PIXEL 12
+
+// UART data bits for each pair of WS2812 bits (MSB first): 00, 01, 10, 11
+static const uint8_t WS2812_UART_LUT[4] = { 0b110111, 0b000111, 0b110100, 0b000100 };
+
+// Per-channel output scale for a global brightness and color correction,
+// computed the way FastLED combines them
+inline CRGB ws2812Adjustment(uint8_t brightness, const CRGB& correction) {
+  CRGB adj(0, 0, 0);
+  for (uint8_t c = 0; c < 3; c++) {
+    if (correction.raw[c]) {
+      adj.raw[c] = (uint8_t)(((uint16_t)(correction.raw[c] + 1) * brightness) >> 8);
+    }
+  }
+  return adj;
+}
+
+inline uint8_t* ws2812EncodeByte(uint8_t value, uint8_t* out) {
+  out[0] = WS2812_UART_LUT[(value >> 6) & 3];
+  out[1] = WS2812_UART_LUT[(value >> 4) & 3];
+  out[2] = WS2812_UART_LUT[(value >> 2) & 3];
+  out[3] = WS2812_UART_LUT[value & 3];
+  return out + 4;
+}
+
+// Encode count pixels in GRB wire order, scaled per channel, into
+// count * WS2812_UART_BYTES_PER_PIXEL bytes at out. Returns the bytes written.
+inline size_t ws2812EncodeUart(const CRGB* pixels, uint16_t count, const CRGB& scale, uint8_t* out) {
+  uint8_t* p = out;
+  for (uint16_t i = 0; i < count; i++) {
+    p = ws2812EncodeByte(scale8(pixels[i].g, scale.g), p);
+    p = ws2812EncodeByte(scale8(pixels[i].r, scale.r), p);
+    p = ws2812EncodeByte(scale8(pixels[i].b, scale.b), p);
+  }
+  return p - out;
+}
+
+#endif // WS2812_ENCODER_H
@@ -6,5 +6,6 @@ const char* EFFECT_NAMES[] = {
   "Fire",
   "Energy Pulse",
   "Rainbow",
-  "Strobe"
+  "Strobe",
+  "POV Image"
 };
\ No newline at end of file
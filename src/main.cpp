@@ -2,6 +2,7 @@
 #include "BoStaff.h"
 #include "hardware.h"
 #include "effects.h"
+#include "RamBudget.h"
 
 // Global configuration
 Config config;
@@ -21,15 +22,19 @@ SettingsManager settingsManager;
 // Power management
 PowerManager powerManager;
 
-// Effect instances
-FireEffect* fireEffect1 = nullptr;
-FireEffect* fireEffect2 = nullptr;
-PulseEffect* pulseEffect1 = nullptr;
-PulseEffect* pulseEffect2 = nullptr;
-RainbowEffect* rainbowEffect1 = nullptr;
-RainbowEffect* rainbowEffect2 = nullptr;
-StrobeEffect* strobeEffect1 = nullptr;
-StrobeEffect* strobeEffect2 = nullptr;
+// Radio off and CPU sleep between frames
+PowerState powerState;
+
+// Deep sleep state in RTC memory, resumed when the staff is picked up
+SleepState sleepState;
+
+// Staged startup - setup() only gets the effect lit, serviceBoot() does the rest
+BootProfile bootProfile;
+bool bootResetIssued = false;  // MPU reset sent, waiting for it to settle
+uint8_t bannerLine = 0;        // Next boot banner line, see printBootBanner()
+
+// ESP8266 UART transmit FIFO; at 115200 baud it empties in about 11 ms
+const int UART_FIFO_BYTES = 128;
 
 // Effect parameters
 EffectParams effectParams[NUM_EFFECTS];
@@ -40,155 +45,265 @@ bool calibrationMode = false;
 unsigned long buttonPressStart = 0;
 bool buttonWasPressed = false;
 
-// I2C and LED timing control variables
+// Accelerometer reads run outside the frame clock so an impact is seen
+// within a couple of milliseconds, not at the next frame
 unsigned long lastAccelUpdate = 0;
-const unsigned long ACCEL_UPDATE_INTERVAL = 25; // Only read accelerometer every 25ms to reduce I2C traffic
+const unsigned long ACCEL_UPDATE_INTERVAL_US = 2000;
 
-// Add global frame rate control
-unsigned long lastFrameTime = 0;
-const unsigned long FRAME_INTERVAL = 50; // 50ms = 20fps, much slower for testing
+// Impact-to-photon latency, printed with the 'l' serial command
+ImpactLatency impactLatency;
 
-// Function to initialize all effect objects
-void initializeAllEffects() {
-  // Clear any existing effects first
-  if (fireEffect1) delete fireEffect1;
-  if (fireEffect2) delete fireEffect2;
-  if (pulseEffect1) delete pulseEffect1;
-  if (pulseEffect2) delete pulseEffect2;
-  if (rainbowEffect1) delete rainbowEffect1;
-  if (rainbowEffect2) delete rainbowEffect2;
-  if (strobeEffect1) delete strobeEffect1;
-  if (strobeEffect2) delete strobeEffect2;
-  
-  // Set all pointers to null (important to prevent dangling pointers)
-  fireEffect1 = nullptr;
-  fireEffect2 = nullptr;
-  pulseEffect1 = nullptr;
-  pulseEffect2 = nullptr;
-  rainbowEffect1 = nullptr;
-  rainbowEffect2 = nullptr;
-  strobeEffect1 = nullptr;
-  strobeEffect2 = nullptr;
-  
-  // Now create all effects fresh
-  bool allEffectsInitialized = true;
-  
-  // Try to create FireEffect instances
-  fireEffect1 = new FireEffect(ledController.getLeds1(), NUM_LEDS_PER_STRIP, false, true); // not reversed, folded
-  fireEffect2 = new FireEffect(ledController.getLeds2(), NUM_LEDS_PER_STRIP, true, true); // reversed, folded
-  
-  if (!fireEffect1 || !fireEffect1->isInitialized() || !fireEffect2 || !fireEffect2->isInitialized()) {
-    Serial.println(F("Error initializing FireEffect!"));
-    allEffectsInitialized = false;
+// Frame pacing - the interval adapts to the render cost
+FrameClock frameClock;
+unsigned long lastFrameStats = 0;
+const unsigned long FRAME_STATS_INTERVAL = 60000; // Print frame timing once a minute
+
+// Scales frame rate, effect detail and sensor rate with battery and load,
+// printed with the 'q' serial command
+QualityGovernor qualityGovernor;
+
+/**
+ * Read the accelerometer and put an impact flash out straight away
+ * Runs every loop() pass, outside the frame clock, so the flash never
+ * waits for a frame
+ */
+void serviceImpacts() {
+  unsigned long now = micros();
+  if (now - lastAccelUpdate < ACCEL_UPDATE_INTERVAL_US) {
+    return;
   }
+  lastAccelUpdate = now;
   
-  // Try to create PulseEffect instances
-  pulseEffect1 = new PulseEffect(ledController.getLeds1(), NUM_LEDS_PER_STRIP, true); // folded
-  pulseEffect2 = new PulseEffect(ledController.getLeds2(), NUM_LEDS_PER_STRIP, true); // folded
-  
-  if (!pulseEffect1 || !pulseEffect2) {
-    Serial.println(F("Error initializing PulseEffect!"));
-    allEffectsInitialized = false;
+  {
+    PROFILE_SCOPE(PROFILE_ACCEL);
+    accelHandler.update();
   }
-  
-  // Try to create RainbowEffect instances
-  rainbowEffect1 = new RainbowEffect(ledController.getLeds1(), NUM_LEDS_PER_STRIP, true); // folded
-  rainbowEffect2 = new RainbowEffect(ledController.getLeds2(), NUM_LEDS_PER_STRIP, true); // folded
-  
-  if (!rainbowEffect1 || !rainbowEffect2) {
-    Serial.println(F("Error initializing RainbowEffect!"));
-    allEffectsInitialized = false;
+  if (!accelHandler.impactDetected()) {
+    return;
   }
   
-  // Try to create StrobeEffect instances
-  strobeEffect1 = new StrobeEffect(ledController.getLeds1(), NUM_LEDS_PER_STRIP, true); // folded
-  strobeEffect2 = new StrobeEffect(ledController.getLeds2(), NUM_LEDS_PER_STRIP, true); // folded
+  ImpactTiming timing;
+  timing.sampleMicros = accelHandler.getImpactMicros();
+  timing.detectMicros = accelHandler.getDetectMicros();
+  ledController.showImpact(timing);
+  impactLatency.record(timing);
   
-  if (!strobeEffect1 || !strobeEffect2) {
-    Serial.println(F("Error initializing StrobeEffect!"));
-    allEffectsInitialized = false;
+  accelHandler.printImpact();
+  powerManager.resetActivityTimer();
+}
+
+/**
+ * Send the image column facing the spin phase (POV mode)
+ * Runs every loop() pass like serviceImpacts(): a column at 5 rev/s is
+ * only ~1.5 ms wide, far shorter than a frame
+ */
+void servicePov() {
+  bool povMode = ledController.isPovMode();
+  accelHandler.setSpinTracking(povMode);
+  if (povMode) {
+    PROFILE_SCOPE(PROFILE_POV);
+    ledController.servicePov(accelHandler.isSpinning(), accelHandler.getSpinPhase(micros()));
+  }
+}
+
+/**
+ * Sleep until the next frame or accelerometer read is due
+ * Not while POV columns are being sent: they need every loop() pass
+ */
+void idleUntilDue() {
+  if (ledController.isPovMode() && accelHandler.isSpinning()) {
+    return;
   }
   
-  // Clear the LED arrays to ensure clean start
-  fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Black);
-  fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Black);
-  FastLED.show();
+  unsigned long deadline = frameClock.nextFrameMicros();
+  unsigned long accelDue = lastAccelUpdate + ACCEL_UPDATE_INTERVAL_US;
+  if ((long)(accelDue - deadline) < 0) {
+    deadline = accelDue;
+  }
+  powerState.sleepUntil(deadline);
+}
+
+/**
+ * Single-letter serial commands
+ */
+void handleSerialCommands() {
+  while (Serial.available() > 0) {
+    // Dumps print directly, after whatever is still queued in the log
+    logger.flush();
+    switch (Serial.read()) {
+      case 'l':
+        impactLatency.print();
+        break;
+      case 'q':
+        qualityGovernor.print();
+        break;
+      case 'b':
+        bootProfile.print();
+        break;
+#if PROFILER_ENABLED
+      case 'p':
+        profiler.printSummary();
+        break;
+      case 't':
+        profiler.dumpTrace();
+        break;
+#endif
+      case '?':
+        Serial.println(F("Commands: l = impact latency histogram, q = quality level, b = boot times"));
+#if PROFILER_ENABLED
+        Serial.println(F("          p = profile summary, t = Chrome trace dump"));
+#endif
+        break;
+    }
+  }
+}
+
+/**
+ * Print one line of the boot banner, each short enough for the empty
+ * UART FIFO; false once they're all out
+ */
+bool printBootBanner(uint8_t line) {
+  if (line >= 2 && line < 2 + RAM_BUDGET_LINES) {
+    printRamBudget(line - 2);
+    return true;
+  }
   
-  if (allEffectsInitialized) {
-    Serial.println(F("All LED effects initialized successfully"));
-  } else {
-    Serial.println(F("WARNING: Some LED effects failed to initialize properly"));
+  switch (line) {
+    case 0:
+      if (sleepState.isResumed()) {
+        Serial.print(F("Resumed from sleep after ")); Serial.print(sleepState.getChecks());
+        Serial.println(F(" wake checks"));
+      }
+      Serial.print(F("Mode ")); Serial.print(EFFECT_NAMES[config.currentMode]);
+      Serial.print(F(", brightness ")); Serial.print(config.brightness);
+      Serial.print(F(", impact brightness ")); Serial.println(config.impactBrightness);
+      return true;
+    case 1:
+      Serial.println(F("Pins: strips D3/D4, MPU SCL D1 SDA D2 INT D5, button D6"));
+      Serial.println(F("Static RAM:"));
+      return true;
+    case 2 + RAM_BUDGET_LINES:
+      Serial.print(F("Free heap: ")); Serial.println(ESP.getFreeHeap());
+      Serial.print(F("Battery: ")); Serial.print(powerManager.getBatteryVoltage()); Serial.print(F("V, "));
+      Serial.print(powerManager.getBatteryPercentage()); Serial.println(F("%"));
+      return true;
+    case 3 + RAM_BUDGET_LINES:
+      Serial.println(F("Hold the button for 5 s to calibrate the accelerometer. Serial commands: ? for help"));
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Run the next background boot stage, at most one per loop() pass so no
+ * frame waits long for them
+ */
+void serviceBoot() {
+  switch (bootProfile.next()) {
+    case BOOT_SENSOR:
+      if (sleepState.isResumed()) {
+        // Still configured from before the sleep
+        accelHandler.start(&config, sleepState.getGyroBias());
+      } else if (!bootResetIssued) {
+        accelHandler.startReset(&config);
+        bootResetIssued = true;
+        return;
+      } else if (!accelHandler.resetDone()) {
+        return;
+      } else {
+        accelHandler.start(&config, 0);
+      }
+      lastAccelUpdate = micros();
+      bootProfile.mark(BOOT_SENSOR);
+      break;
+      
+    case BOOT_STORAGE:
+      if (sleepState.isResumed()) {
+        settingsManager.begin();
+        settingsManager.resume(&config);
+      }
+      bootProfile.mark(BOOT_STORAGE);
+      break;
+      
+    case BOOT_POWER:
+      powerManager.begin(&settingsManager, &sleepState);
+      qualityGovernor.begin(&frameClock, &ledController, &accelHandler);
+      bootProfile.mark(BOOT_POWER);
+      break;
+      
+    case BOOT_DIAGNOSTICS:
+      // One banner line per pass, and only once the log is out and the
+      // UART FIFO is empty, so no line waits for the UART
+      logger.drain();
+      if (!logger.empty() || Serial.availableForWrite() < UART_FIFO_BYTES) {
+        return;
+      }
+      if (printBootBanner(bannerLine++)) {
+        return;
+      }
+      bootProfile.mark(BOOT_DIAGNOSTICS);
+      bootProfile.print();
+      lastFrameStats = millis();
+      break;
+      
+    default:
+      break;
   }
 }
 
 void setup() {
+  // A sleep check wake without motion goes back to sleep in here
+  bool resumed = sleepState.begin(&config, &accelHandler, &ledController);
+  
   // Initialize serial communication
   Serial.begin(SERIAL_BAUD);
-  Serial.println(F("\nBoStaff Controller Starting"));
-  Serial.print(F("Version: ")); Serial.println(VERSION);
-  Serial.print(F("Build: ")); Serial.print(BUILD_DATE); Serial.print(" "); Serial.println(BUILD_TIME);
-  
-  // Display pin configuration
-  Serial.println(F("\nPin Configuration:"));
-  Serial.print(F("LED Strip 1: ")); Serial.print(F("D3 (GPIO0)")); Serial.println(F(" - was D1 (GPIO5)"));
-  Serial.print(F("LED Strip 2: ")); Serial.print(F("D4 (GPIO2)")); Serial.println(F(" - was D2 (GPIO4)"));
-  Serial.print(F("MPU-6050 SCL: ")); Serial.println(F("D1 (GPIO5)"));
-  Serial.print(F("MPU-6050 SDA: ")); Serial.println(F("D2 (GPIO4)"));
-  Serial.print(F("Button: ")); Serial.println(F("D6 (GPIO12)"));
-  
-  // Initialize I2C for MPU-6050 (uses default pins D1/D2)
-  Wire.begin(SDA_PIN, SCL_PIN);
-  Serial.println(F("I2C initialized"));
-  
-  // Load settings from flash
-  settingsManager.begin();
-  settingsManager.loadSettings(&config);
+  Serial.print(F("\nBoStaff ")); Serial.print(VERSION);
+  Serial.print(F(", built ")); Serial.print(BUILD_DATE); Serial.print(' '); Serial.println(BUILD_TIME);
+  powerState.begin();
+  bootProfile.mark(BOOT_SERIAL);
+  
+  // Load settings from flash (after a sleep they came from RTC memory)
+  if (!resumed) {
+    settingsManager.begin();
+    settingsManager.loadSettings(&config);
+  }
+  bootProfile.mark(BOOT_SETTINGS);
   
   // Initialize button - must be before LED controller to ensure proper boot state
   buttonHandler.begin(&config);
   
-  // Initialize LED controller
+  // First light: the saved effect, before the sensor and diagnostics
+  // (only the active effect is constructed), at the battery's power budget
   ledController.begin(&config);
-  
-  // Initialize accelerometer
-  accelHandler.begin(&config);
-  
-  // Initialize power management
-  powerManager.begin();
-  
-  // Initialize effect objects with correct folded arrangement
-  // true = folded arrangement (LEDs 0 and 199 at center, 99 and 100 at far end)
-  // false = linear arrangement
-  Serial.println(F("Initializing LED effects for folded strip arrangement"));
-  Serial.println(F("(LEDs 0 and 199 at center/hilt, LEDs 99 and 100 at far end)"));
-  
-  // Initialize all effects
-  initializeAllEffects();
-  
-  // Set the initial mode
+  powerManager.beginBattery(&ledController);
   ledController.setMode(config.currentMode);
-  
-  Serial.println(F("Setup complete!"));
-  
-  // Show battery status
-  float batteryVoltage = powerManager.getBatteryVoltage();
-  float batteryPercentage = powerManager.getBatteryPercentage();
-  Serial.print(F("Battery: ")); Serial.print(batteryVoltage); Serial.print(F("V, ")); 
-  Serial.print(batteryPercentage); Serial.println(F("%"));
-  
-  // Print calibration instructions
-  Serial.println(F("\nTo enter accelerometer calibration mode,"));
-  Serial.println(F("hold the button for 5 seconds until all LEDs flash blue."));
-  
-  // Initialize accelerometer update timing
-  lastAccelUpdate = millis();
-  lastFrameTime = millis();
+  sleepState.restoreEffects();
+  FrameTime frameTime = frameClock.beginFrame();
+  ledController.update(frameTime);
+  frameClock.endFrame();
+  bootProfile.mark(BOOT_FIRST_LIGHT);
+  
+  // The rest of the boot runs from loop(), see serviceBoot()
+  lastAccelUpdate = micros();
+  lastFrameStats = millis();
 }
 
 void loop() {
-  // Global frame rate control - only update visuals at set intervals
-  unsigned long currentMillis = millis();
-  if (currentMillis - lastFrameTime < FRAME_INTERVAL) {
+  PROFILE_LOOP();
+  
+  if (!bootProfile.done()) {
+    serviceBoot();
+  }
+  
+  if (!calibrationMode && bootProfile.next() > BOOT_SENSOR) {
+    serviceImpacts();
+    servicePov();
+  }
+  handleSerialCommands();
+  
+  // Global frame rate control - only update visuals when the frame clock says so
+  if (!frameClock.due()) {
     // Not enough time has passed, just handle button input and yield
     if (digitalRead(BTN_PIN) == LOW) {  // Button pressed (active LOW)
       if (!buttonWasPressed) {
@@ -205,13 +320,15 @@ void loop() {
     }
     
     // Skip the rest of the loop until it's time for the next frame
+    PROFILE_SCOPE(PROFILE_IDLE);
+    logger.drain();
     yield();
+    if (!calibrationMode) {
+      idleUntilDue();
+    }
     return;
   }
   
-  // Reset lastFrameTime for next frame
-  lastFrameTime = currentMillis;
-  
   // Check for calibration mode trigger (long button press)
   if (digitalRead(BTN_PIN) == LOW) {  // Button pressed (active LOW)
     if (!buttonWasPressed) {
@@ -221,32 +338,22 @@ void loop() {
       // Long press detected, enter calibration mode
       calibrationMode = true;
       
-      // Disable all interrupts to ensure clean LED operations
-      noInterrupts();
-      
       // Clear both strips completely before visual feedback
-      fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Black);
-      fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Black);
-      FastLED.show();
+      ledController.fill(CRGB::Black);
+      ledController.show();
       delay(100);
       
       // Visual feedback - flash LEDs blue to indicate calibration mode
-      for (int i = 0; i < NUM_LEDS_PER_STRIP; i++) {
-        ledController.getLeds1()[i] = CRGB::Blue;
-        ledController.getLeds2()[i] = CRGB::Blue;
-      }
-      FastLED.show();
+      ledController.fill(CRGB::Blue);
+      ledController.show();
       delay(500);
       
       // Clear both strips completely 
-      fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Black);
-      fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Black);
-      FastLED.show();
+      ledController.fill(CRGB::Black);
+      ledController.show();
       delay(500);
       
-      // Re-enable interrupts
-      interrupts();
-      
+      logger.flush();
       Serial.println(F("\n*** ENTERING CALIBRATION MODE ***"));
       
       // Start the calibration process
@@ -254,31 +361,19 @@ void loop() {
       
       // Save the new threshold value
       settingsManager.saveSettings(&config);
+      settingsManager.flush();
       
       Serial.print(F("New impact threshold saved: "));
       Serial.println(config.impactThreshold);
       
-      // Disable interrupts again
-      noInterrupts();
-      
       // Visual feedback - flash LEDs green to indicate calibration complete
-      for (int i = 0; i < NUM_LEDS_PER_STRIP; i++) {
-        ledController.getLeds1()[i] = CRGB::Green;
-        ledController.getLeds2()[i] = CRGB::Green;
-      }
-      FastLED.show();
+      ledController.fill(CRGB::Green);
+      ledController.show();
       delay(1000);
       
       // Clear both strips completely before restoring normal operation
-      fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Black);  
-      fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Black);
-      FastLED.show();
-      
-      // Re-enable interrupts
-      interrupts();
-      
-      // Completely reinitialize all effect objects to ensure clean state
-      initializeAllEffects();
+      ledController.fill(CRGB::Black);
+      ledController.show();
       
       // Reset calibration mode
       calibrationMode = false;
@@ -286,7 +381,7 @@ void loop() {
       // Make sure brightness is restored
       FastLED.setBrightness(config.brightness);
       
-      // Restore current LED effect
+      // Restore current LED effect - rebuilds it from a clean state
       ledController.setMode(config.currentMode);
       
       // Force a clean update of the strips
@@ -302,90 +397,48 @@ void loop() {
   }
   
   // Update button state
-  buttonHandler.handle();
+  {
+    PROFILE_SCOPE(PROFILE_BUTTON);
+    buttonHandler.handle();
+  }
   
   // Check for mode change request from button
   if (buttonHandler.modeChangeRequested()) {
     config.currentMode = (config.currentMode + 1) % config.numModes;
-    Serial.print(F("Mode changed to: ")); Serial.print(config.currentMode); 
-    Serial.print(F(" (")); Serial.print(EFFECT_NAMES[config.currentMode]); Serial.println(F(")"));
+    LOG_INFO("Mode changed to: %u (%s)", config.currentMode, EFFECT_NAMES[config.currentMode]);
     
     ledController.setMode(config.currentMode);
-    settingsManager.saveSettings(&config);
+    settingsManager.saveSettings(&config);  // Written after a quiet period, not now
     powerManager.resetActivityTimer();
   }
   
-  // Only read accelerometer at a controlled rate to avoid I2C timing conflicts
-  if (millis() - lastAccelUpdate >= ACCEL_UPDATE_INTERVAL) {
-    // Read accelerometer and detect impacts
-    accelHandler.update();
-    lastAccelUpdate = millis();
-    
-    // If impact detected, trigger flash effect
-    if (accelHandler.impactDetected()) {
-      ledController.triggerImpactEffect();
-      powerManager.resetActivityTimer();
+  // Render the active effect and update LED strips - unchanged frames are not resent
+  FrameTime frameTime = frameClock.beginFrame();
+  ledController.update(frameTime);
+  frameClock.endFrame(ledController.getTransitionCost());
+  
+  if (bootProfile.done() && frameTime.now - lastFrameStats >= FRAME_STATS_INTERVAL) {
+    frameClock.printStats();
+    accelHandler.printStats();
+    powerState.printStats();
+    ledController.printPowerStats();
+    if (ledController.isPovMode()) {
+      ledController.printPovStats();
     }
+    lastFrameStats = frameTime.now;
   }
   
-  // Update LED effects based on current mode
-  switch (config.currentMode) {
-    case EFFECT_FIRE:
-      if (fireEffect1 && fireEffect2 && fireEffect1->isInitialized() && fireEffect2->isInitialized()) {
-        fireEffect1->update();
-        fireEffect2->update();
-      } else {
-        // Fallback to a simple effect if fire effect is not available
-        fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Red);
-        fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Red);
-      }
-      break;
-      
-    case EFFECT_PULSE:
-      if (pulseEffect1 && pulseEffect2) {
-        pulseEffect1->update();
-        pulseEffect2->update();
-      } else {
-        // Fallback effect
-        fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Blue);
-        fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Blue);
-      }
-      break;
-      
-    case EFFECT_RAINBOW:
-      if (rainbowEffect1 && rainbowEffect2) {
-        rainbowEffect1->update();
-        rainbowEffect2->update();
-      } else {
-        // Fallback effect
-        fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::Green);
-        fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::Green);
-      }
-      break;
-      
-    case EFFECT_STROBE:
-      if (strobeEffect1 && strobeEffect2) {
-        strobeEffect1->update();
-        strobeEffect2->update();
-      } else {
-        // Fallback effect
-        fill_solid(ledController.getLeds1(), NUM_LEDS_PER_STRIP, CRGB::White);
-        fill_solid(ledController.getLeds2(), NUM_LEDS_PER_STRIP, CRGB::White);
-      }
-      break;
-      
-    case EFFECT_SOLID:
-    default:
-      // Solid color effect is handled directly by LED controller
-      break;
+  // Update power management (started by serviceBoot())
+  if (bootProfile.done()) {
+    PROFILE_SCOPE(PROFILE_POWER);
+    powerManager.update();
+    qualityGovernor.update(powerManager.getBatteryVoltage());
   }
   
-  // Update LED strips - this will call FastLED.show() internally
-  ledController.update();
-  
-  // Update power management
-  powerManager.update();
+  // Write settings once they've stopped changing
+  settingsManager.update();
   
-  // Small delay to prevent watchdog issues
+  // Send queued log lines while there's FIFO room, then yield
+  logger.drain();
   yield();
 }
\ No newline at end of file
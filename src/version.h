@@ -24,6 +24,22 @@
 #define LED_TYPE WS2812B
 #define COLOR_ORDER GRB
 
+// Clock strip 2 out of UART1 in the background instead of bit-banging it
+// (D4/GPIO2 is the UART1 TX pin). Strip 1 on D3 has no UART, so it stays on FastLED.
+#ifndef LED_OUTPUT_ASYNC
+#define LED_OUTPUT_ASYNC 1
+#endif
+
+// Mode changes crossfade from the old effect to the new one over this long
+// (0 = hard cut through black, and the second effect layer isn't allocated)
+#ifndef EFFECT_TRANSITION_MS
+#define EFFECT_TRANSITION_MS 400
+#endif
+#define EFFECT_LAYERS (EFFECT_TRANSITION_MS > 0 ? 2 : 1)
+// A crossfade frame may take this much longer than a plain one (the second
+// effect and the blend); a slower one ends the fade on the new effect
+#define TRANSITION_MAX_COST_US 2000
+
 // Button configuration
 #define BUTTON_PIN D6  // GPIO12
 #define BUTTON_ACTIVE_LOW true
@@ -36,8 +52,89 @@
 #define IMPACT_FLASH_DURATION_MS 100
 #define IMPACT_COOLDOWN_MS 500
 
+// Sample through the MPU6050 FIFO with the data-ready interrupt on D5
+// instead of polling one reading every 25 ms (0 = polling)
+#ifndef MPU_FIFO_SAMPLING
+#define MPU_FIFO_SAMPLING 1
+#endif
+#define MPU_SAMPLE_RATE_HZ 1000  // 1000 or 500
+
+// POV image mode - the gyro axis the staff spins around (0 = X, 1 = Y, 2 = Z)
+// and the rate above which the image is shown instead of the preview
+#define MPU_SPIN_AXIS 2
+#define POV_MIN_SPIN_DPS 180
+
+// Logging - lines are formatted into a RAM ring and sent to Serial only as
+// fast as the UART FIFO takes them; lines that don't fit are dropped.
+// Levels above LOG_LEVEL compile out, arguments and all.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_BUFFER_SIZE 1024  // Power of two
+#define LOG_LINE_MAX 128      // Longer lines are cut
+
+// Cycle-count profiler for the loop() stages, dumped over serial ('p', 't').
+// Off compiles every hook out to nothing.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+#define PROFILER_RING_SIZE 256  // Trace events kept, 8 bytes each
+
+// Static RAM allowed for frame buffers, effect state and diagnostic rings
+// (src/RamBudget.h); the build fails if they add up to more
+#ifndef RAM_BUDGET_BYTES
+#define RAM_BUDGET_BYTES 16384
+#endif
+
+// Halt the CPU between frames instead of spinning in loop(); a timer at
+// the next deadline, the button, the MPU interrupt or serial wake it
+#ifndef IDLE_SLEEP
+#define IDLE_SLEEP 1
+#endif
+#define IDLE_MIN_SLEEP_US 100  // Shorter waits spin, waking costs a few us
+
 // Power settings
 #define POWER_SAVING_MODE 1
 #define SLEEP_AFTER_MINS 30
 
+// Deep sleep wake. With SLEEP_WAKE_ON_INT the MPU INT line resets the board
+// through a filtered one-shot (docs/pin-assignments.md) as soon as it sees
+// motion, and the timer (GPIO16/D0 wired to RST) only backs it up. Without
+// that circuit set it to 0: the timer then asks the MPU every 500 ms, which
+// costs latency and far more sleep current (docs/design-notes.md)
+#ifndef SLEEP_WAKE_ON_INT
+#define SLEEP_WAKE_ON_INT 1
+#endif
+#if SLEEP_WAKE_ON_INT
+#define SLEEP_WAKE_CHECK_MS 60000
+#else
+#define SLEEP_WAKE_CHECK_MS 500
+#endif
+
+// LED current budget - frames estimated to draw more are dimmed to fit.
+// PowerManager switches to the low budget while the battery is low.
+#define LED_POWER_BUDGET_MA 2000
+#define LED_POWER_BUDGET_LOW_MA 1000
+
+// Quality governor - a level is dropped after GOVERNOR_DOWN_CHECKS checks
+// over the frame budget and regained after GOVERNOR_UP_CHECKS checks under
+// GOVERNOR_HEADROOM_PCT of it, so it doesn't flap around the limit
+#define GOVERNOR_CHECK_MS 1000
+#define GOVERNOR_FRAME_BUDGET_US 15000
+#define GOVERNOR_DOWN_CHECKS 2
+#define GOVERNOR_UP_CHECKS 10
+#define GOVERNOR_HEADROOM_PCT 60
+
+// Battery voltages below which a level is the best allowed; the voltage
+// must rise GOVERNOR_BATTERY_HYSTERESIS above one to climb back
+#define GOVERNOR_BATTERY_REDUCED 3.7
+#define GOVERNOR_BATTERY_ECO 3.5
+#define GOVERNOR_BATTERY_MINIMAL 3.3
+#define GOVERNOR_BATTERY_HYSTERESIS 0.1
+
 #endif // VERSION_H
\ No newline at end of file
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Convert an image into a polar POV image header for the BoStaff POV mode.
+
+The staff draws the image by spinning around the hilt, so the image is
+stored as columns (angles) of radial pixels from the hilt outwards, with
+4-bit palette indices (two pixels per byte) in flash.
+
+    python3 tools/pov_image.py logo.png > src/PovImages.cpp
+    python3 tools/pov_image.py --demo > src/PovImages.cpp
+
+Image input needs Pillow; the image is centred, scaled to fit the disc and
+reduced to 16 colours. --demo draws the built-in star without Pillow.
+"""
+
+import argparse
+import math
+import sys
+
+COLUMNS = 128   # Angular resolution, one column per 2.8 degrees
+RADIUS = 50     # Radial pixels, each covers two LEDs of a 100-LED half-strip
+
+
+def demo_pixel(x, y):
+    """Built-in image: a yellow five-pointed star in a blue ring, x/y in -1..1."""
+    r = math.hypot(x, y)
+    a = math.atan2(y, x)
+    if r < 0.08:
+        return (255, 255, 255)
+    if 0.86 <= r <= 0.98:
+        return (0, 80, 255)
+    # Star outline radius at this angle, between the inner and outer points
+    sector = (a + math.pi / 2) % (2 * math.pi / 5) - math.pi / 5
+    inner, outer = 0.32, 0.8
+    star_r = inner + (outer - inner) * (1 - abs(sector) / (math.pi / 5)) ** 2
+    if r <= star_r:
+        return (255, 200, 0)
+    return (0, 0, 0)
+
+
+def image_sampler(path):
+    from PIL import Image
+    img = Image.open(path).convert("RGB")
+    size = min(img.size)
+    img = img.crop(((img.width - size) // 2, (img.height - size) // 2,
+                    (img.width + size) // 2, (img.height + size) // 2))
+    img = img.quantize(16).convert("RGB")
+
+    def sample(x, y):
+        px = int((x + 1) / 2 * (size - 1))
+        py = int((1 - (y + 1) / 2) * (size - 1))
+        return img.getpixel((px, py))
+    return sample
+
+
+def build(sample):
+    palette = [(0, 0, 0)]
+    columns = []
+    for c in range(COLUMNS):
+        angle = 2 * math.pi * c / COLUMNS
+        column = []
+        for r in range(RADIUS):
+            radius = (r + 0.5) / RADIUS
+            color = sample(radius * math.cos(angle), radius * math.sin(angle))
+            if color not in palette:
+                if len(palette) == 16:
+                    # Nearest existing colour once the palette is full
+                    color = min(palette, key=lambda p: sum((a - b) ** 2 for a, b in zip(p, color)))
+                else:
+                    palette.append(color)
+            column.append(palette.index(color))
+        columns.append(column)
+    palette += [(0, 0, 0)] * (16 - len(palette))
+    return palette, columns
+
+
+def emit(palette, columns, source):
+    out = sys.stdout
+    out.write("// Generated by tools/pov_image.py from %s - do not edit\n\n" % source)
+    out.write("#include \"Effects/PovImage.h\"\n\n")
+    out.write("static const uint8_t POV_PALETTE[16 * 3] PROGMEM = {\n")
+    for p in palette:
+        out.write("  %d, %d, %d,\n" % p)
+    out.write("};\n\n")
+    out.write("static const uint8_t POV_PIXELS[%d * %d / 2] PROGMEM = {\n" % (COLUMNS, RADIUS))
+    for column in columns:
+        packed = [column[i] | (column[i + 1] << 4) for i in range(0, RADIUS, 2)]
+        out.write("  " + ", ".join("0x%02x" % b for b in packed) + ",\n")
+    out.write("};\n\n")
+    out.write("const PovImage POV_IMAGE = { %d, %d, POV_PALETTE, POV_PIXELS };\n"
+              % (COLUMNS, RADIUS))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", nargs="?", help="image file (needs Pillow)")
+    parser.add_argument("--demo", action="store_true", help="emit the built-in demo image")
+    args = parser.parse_args()
+    if args.demo or not args.image:
+        emit(*build(demo_pixel), "the built-in demo")
+    else:
+        emit(*build(image_sampler(args.image)), args.image)
+
+
+if __name__ == "__main__":
+    main()